@@ -0,0 +1,232 @@
+#include "searchctx.h"
+#include "mapfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ALT heuristic: A*, landmarks and the triangle inequality.
+// A handful of sea cells on the edge of the main ocean are picked by farthest-point
+// selection, and a Dijkstra from each records the sea distance to every cell. For a
+// landmark L, |d(L,goal) - d(L,cell)| bounds the remaining distance from below, and it
+// follows coastlines, so the search no longer floods a basin before finding its exit.
+//
+// Distances leave out wind. Storms only add cost, so the tables stay admissible under
+// any weather and never need rebuilding after updateWeatherSimulation(). Coastal
+// padding is part of the grid and is included.
+//
+// Tables are stored cell-major (all landmarks of a cell share a cache line) as
+// fixed-point uint16, and the file is memory-mapped so processes share the pages.
+
+#define ALT_VERSION 2
+#define ALT_UNREACHED 0xFFFF
+#define ALT_SATURATED 0xFFFE    // true distance is at least this
+
+typedef struct {
+    char magic[4];              // "ALT\0"
+    uint32_t version;
+    int32_t gridW, gridH, count;
+    float scale;                // stored value = floor(distance * scale)
+    uint32_t gridHash;          // collision grid the tables were computed on
+    int32_t wraps;              // and whether its columns wrapped (setMapWraps)
+    int32_t cells[ALT_MAX_LANDMARKS];
+} AltHeader;
+
+const uint16_t* altDist = NULL;
+int altCount = 0;
+float altScale = 1.0f;
+static const void* mapping = NULL;
+static size_t mappingSize = 0;
+static uint16_t* ownedTables = NULL;   // built here but not saved
+static int altW = 0, altH = 0;
+
+static uint32_t gridHash() {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (int i = 0; i < gridW * gridH; i++) h = (h ^ collisionGrid[i]) * 16777619u;
+    return h;
+}
+
+void freeLandmarks() {
+    unmapFile(mapping, mappingSize);
+    mapping = NULL; mappingSize = 0;
+    free(ownedTables); ownedTables = NULL;
+    altDist = NULL;
+    altCount = 0;
+    altW = altH = 0;
+}
+
+static int landmarksValid() {
+    return altDist && altW == gridW && altH == gridH;
+}
+
+void beginHeuristic(SearchContext* ctx, int goalIdx) {
+    ctx->wrapW = wrapColumns ? gridW : 1 << 30;
+    ctx->altReady = ctx->heuristic == HEURISTIC_ALT && landmarksValid();
+    if (!ctx->altReady) return;
+    memcpy(ctx->altGoal, altDist + (size_t)goalIdx * altCount, altCount * sizeof(uint16_t));
+    ctx->altGoalPenalty = landmarkPenalty(goalIdx) * altScale;
+}
+
+// --- Building ---
+// Weather-free Dijkstra over the whole grid; costs end up in ctx->g/stamp.
+static void seaDistances(SearchContext* ctx, int src) {
+    beginSearch(ctx);
+    OpenList* openList = &ctx->openList;
+    float* gScore = ctx->g;
+    uint32_t* stamp = ctx->stamp;
+    uint32_t gen = ctx->generation;
+    stamp[src] = gen;
+    gScore[src] = 0;
+    openPush(openList, src, 0);
+
+    int currIdx;
+    float currF;
+    while ((currIdx = openPop(openList, &currF)) >= 0) {
+        float currG = gScore[currIdx];
+        if (currF > currG) continue; // superseded duplicate
+        int currR = currIdx / gridW, currC = currIdx % gridW;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                if (dr == 0 && dc == 0) continue;
+                int nr = currR + dr, nc = stepColumn(currC + dc);
+                if (nr < 0 || nr >= gridH || nc < 0 || collisionGrid[nr * gridW + nc] == 1) continue;
+                int idx = nr * gridW + nc;
+                float tentativeG = currG + (dr != 0 && dc != 0 ? STEP_DIAGONAL : STEP_STRAIGHT) + landmarkPenalty(idx);
+                if (stamp[idx] != gen || tentativeG < gScore[idx]) {
+                    stamp[idx] = gen;
+                    gScore[idx] = tentativeG;
+                    openPush(openList, idx, tentativeG);
+                }
+            }
+        }
+    }
+}
+
+// A cell of the largest connected body of water; landmarks elsewhere would be useless
+// for almost every query.
+static int mainSeaCell() {
+    int cells = gridW * gridH;
+    int* label = (int*)calloc(cells, sizeof(int));
+    int* queue = (int*)malloc(cells * sizeof(int));
+    int best = -1, bestSize = 0, next = 0;
+    for (int i = 0; i < cells; i++) {
+        if (collisionGrid[i] == 1 || label[i]) continue;
+        int head = 0, tail = 0;
+        label[i] = ++next;
+        queue[tail++] = i;
+        while (head < tail) {
+            int idx = queue[head++], r = idx / gridW, c = idx % gridW;
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    int nr = r + dr, nc = stepColumn(c + dc);
+                    if (nr < 0 || nr >= gridH || nc < 0) continue;
+                    int n = nr * gridW + nc;
+                    if (collisionGrid[n] == 1 || label[n]) continue;
+                    label[n] = next;
+                    queue[tail++] = n;
+                }
+            }
+        }
+        if (tail > bestSize) { bestSize = tail; best = i; }
+    }
+    free(label); free(queue);
+    return best;
+}
+
+static int writeLandmarks(const char* path, const AltHeader* header, const uint16_t* tables) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    size_t n = (size_t)header->gridW * header->gridH * header->count;
+    int ok = fwrite(header, sizeof(*header), 1, f) == 1 && fwrite(tables, sizeof(uint16_t), n, f) == n;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) remove(path);
+    return ok;
+}
+
+int buildLandmarks(int count, const char* path) {
+    freeLandmarks();
+    if (!collisionGrid || count <= 0) return 0;
+    if (count > ALT_MAX_LANDMARKS) count = ALT_MAX_LANDMARKS;
+    int seed = mainSeaCell();
+    if (seed < 0) return 0;
+
+    int cells = gridW * gridH;
+    SearchContext* ctx = searchContextCreate();
+    AltHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "ALT", 4);
+    header.version = ALT_VERSION;
+    header.gridW = gridW; header.gridH = gridH; header.count = count;
+    header.gridHash = gridHash();
+    header.wraps = wrapColumns;
+
+    // No sea distance exceeds twice the eccentricity of the seed, which fixes the
+    // fixed-point scale before any table is written.
+    seaDistances(ctx, seed);
+    float reach = 0;
+    int farthest = seed;
+    for (int i = 0; i < cells; i++)
+        if (ctx->stamp[i] == ctx->generation && ctx->g[i] > reach) { reach = ctx->g[i]; farthest = i; }
+    header.scale = reach > 0 ? (ALT_SATURATED - 1) / (2.0f * reach) : 1.0f;
+
+    uint16_t* tables = (uint16_t*)malloc((size_t)cells * count * sizeof(uint16_t));
+    float* nearest = (float*)malloc(cells * sizeof(float));
+    for (int i = 0; i < cells; i++) nearest[i] = INFINITY;
+    int landmark = farthest;
+    for (int l = 0; l < count; l++) {
+        header.cells[l] = landmark;
+        seaDistances(ctx, landmark);
+        int next = landmark;
+        float nextDist = 0;
+        for (int i = 0; i < cells; i++) {
+            uint16_t q = ALT_UNREACHED;
+            if (ctx->stamp[i] == ctx->generation) {
+                float d = ctx->g[i];
+                float scaled = d * header.scale;
+                q = scaled >= ALT_SATURATED ? ALT_SATURATED : (uint16_t)scaled;
+                if (d < nearest[i]) nearest[i] = d;
+                if (nearest[i] > nextDist) { nextDist = nearest[i]; next = i; }
+            }
+            tables[(size_t)i * count + l] = q;
+        }
+        landmark = next;
+    }
+    free(nearest);
+    searchContextFree(ctx);
+
+    if (path && writeLandmarks(path, &header, tables) && loadLandmarks(path)) {
+        free(tables);
+        return 1;
+    }
+    // Could not save: keep the tables in memory for this run.
+    ownedTables = tables;
+    altDist = tables;
+    altCount = count;
+    altScale = header.scale;
+    altW = gridW; altH = gridH;
+    return 1;
+}
+
+int loadLandmarks(const char* path) {
+    freeLandmarks();
+    if (!collisionGrid) return 0;
+    size_t size = 0;
+    const void* data = mapFile(path, &size);
+    if (!data) return 0;
+    const AltHeader* header = (const AltHeader*)data;
+    int ok = size >= sizeof(AltHeader) && !memcmp(header->magic, "ALT", 4) && header->version == ALT_VERSION &&
+             header->gridW == gridW && header->gridH == gridH &&
+             header->count > 0 && header->count <= ALT_MAX_LANDMARKS &&
+             size == sizeof(AltHeader) + (size_t)gridW * gridH * header->count * sizeof(uint16_t) &&
+             header->gridHash == gridHash() && header->wraps == wrapColumns;
+    if (!ok) { unmapFile(data, size); return 0; }
+    mapping = data; mappingSize = size;
+    altDist = (const uint16_t*)((const char*)data + sizeof(AltHeader));
+    altCount = header->count;
+    altScale = header->scale;
+    altW = gridW; altH = gridH;
+    return 1;
+}
+
+int landmarkCount() {
+    return landmarksValid() ? altCount : 0;
+}
@@ -0,0 +1,209 @@
+#include "asyncroute.h"
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One request slot and one result slot, both under the lock. Starting a request fills
+// the slot and raises cancel so a search in progress stops at its next poll; the
+// worker clears cancel as it takes the slot. A stopped search delivers nothing, and a
+// finished one only if no newer request arrived meanwhile.
+
+#define SNAPSHOT_MS 30
+
+struct AsyncRoute {
+    SDL_Thread* worker;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    SDL_atomic_t cancel;
+    Planner* planner;
+    int quit;
+
+    int pending;            // a request waits in start/goal
+    GridPos start, goal;
+    unsigned request;       // bumped by every asyncRouteStart()
+    int running;
+
+    int resultReady, resultFound;
+    RoutePath result;
+
+    RouteProgress snap;     // published by the worker
+    // Worker thread only, never locked.
+    Uint32 lastSnap;
+    GridPos frontier[ASYNC_FRONTIER_MAX];
+};
+
+static void clearPath(RoutePath* path) {
+    freePath(path);
+    path->cells = NULL; path->len = 0; path->cost = 0; path->expanded = 0; path->hours = 0;
+}
+
+static int onProgress(void* user, Planner* planner, int expanded) {
+    AsyncRoute* ar = (AsyncRoute*)user;
+    if (SDL_AtomicGet(&ar->cancel)) return 1;
+    Uint32 now = SDL_GetTicks();
+    if (now - ar->lastSnap < SNAPSHOT_MS) return 0;
+    ar->lastSnap = now;
+    // Gathered outside the lock; only the swap into snap holds it.
+    int n = plannerFrontier(planner, ar->frontier, ASYNC_FRONTIER_MAX);
+    RoutePath partial;
+    plannerPartialRoute(planner, &partial);
+    SDL_LockMutex(ar->lock);
+    if (SDL_AtomicGet(&ar->cancel)) {     // superseded while gathering
+        SDL_UnlockMutex(ar->lock);
+        freePath(&partial);
+        return 1;
+    }
+    ar->snap.frontier = (GridPos*)realloc(ar->snap.frontier, sizeof(GridPos) * (n > 0 ? n : 1));
+    memcpy(ar->snap.frontier, ar->frontier, sizeof(GridPos) * n);
+    ar->snap.frontierLen = n;
+    if (partial.len > 0) { clearPath(&ar->snap.partial); ar->snap.partial = partial; }
+    ar->snap.expanded = expanded;
+    ar->snap.serial++;
+    SDL_UnlockMutex(ar->lock);
+    return 0;
+}
+
+static int workerMain(void* arg) {
+    AsyncRoute* ar = (AsyncRoute*)arg;
+    SDL_LockMutex(ar->lock);
+    for (;;) {
+        while (!ar->quit && !ar->pending) SDL_CondWait(ar->wake, ar->lock);
+        if (ar->quit) break;
+        GridPos start = ar->start, goal = ar->goal;
+        unsigned request = ar->request;
+        ar->pending = 0;
+        ar->running = 1;
+        SDL_AtomicSet(&ar->cancel, 0);
+        SDL_UnlockMutex(ar->lock);
+        ar->lastSnap = 0;   // the new request's first poll publishes at once
+
+        RoutePath path, taut = { NULL, 0, 0, 0, 0 };
+        int found = plannerRoute(ar->planner, start, goal, &path);
+        int stopped = plannerStopped(ar->planner);
+        if (found) {
+            smoothPath(&path, &taut);
+            freePath(&path);
+        }
+
+        SDL_LockMutex(ar->lock);
+        ar->running = 0;
+        if (!stopped && request == ar->request) {
+            clearPath(&ar->result);
+            ar->result = taut;
+            ar->resultFound = found;
+            ar->resultReady = 1;
+        } else freePath(&taut);
+    }
+    SDL_UnlockMutex(ar->lock);
+    return 0;
+}
+
+AsyncRoute* asyncRouteCreate() {
+    AsyncRoute* ar = (AsyncRoute*)calloc(1, sizeof(AsyncRoute));
+    if (!ar) return NULL;
+    ar->lock = SDL_CreateMutex();
+    ar->wake = SDL_CreateCond();
+    ar->planner = plannerCreate();
+    plannerSetProgress(ar->planner, onProgress, ar);
+    ar->worker = SDL_CreateThread(workerMain, "router", ar);
+    if (!ar->lock || !ar->wake || !ar->planner || !ar->worker) {
+        if (ar->worker) { ar->quit = 1; SDL_CondSignal(ar->wake); SDL_WaitThread(ar->worker, NULL); }
+        if (ar->lock) SDL_DestroyMutex(ar->lock);
+        if (ar->wake) SDL_DestroyCond(ar->wake);
+        plannerFree(ar->planner);
+        free(ar);
+        return NULL;
+    }
+    return ar;
+}
+
+void asyncRouteFree(AsyncRoute* ar) {
+    if (!ar) return;
+    SDL_LockMutex(ar->lock);
+    ar->quit = 1;
+    SDL_AtomicSet(&ar->cancel, 1);
+    SDL_CondSignal(ar->wake);
+    SDL_UnlockMutex(ar->lock);
+    SDL_WaitThread(ar->worker, NULL);
+    SDL_DestroyMutex(ar->lock);
+    SDL_DestroyCond(ar->wake);
+    plannerFree(ar->planner);
+    freePath(&ar->result);
+    routeProgressFree(&ar->snap);
+    free(ar);
+}
+
+void asyncRouteStart(AsyncRoute* ar, GridPos start, GridPos goal) {
+    SDL_LockMutex(ar->lock);
+    ar->start = start;
+    ar->goal = goal;
+    ar->pending = 1;
+    ar->request++;
+    ar->resultReady = 0;
+    // A fresh snapshot for the new request.
+    ar->snap.frontierLen = 0;
+    clearPath(&ar->snap.partial);
+    ar->snap.expanded = 0;
+    ar->snap.serial++;
+    SDL_AtomicSet(&ar->cancel, 1);
+    SDL_CondSignal(ar->wake);
+    SDL_UnlockMutex(ar->lock);
+}
+
+void asyncRouteCancel(AsyncRoute* ar) {
+    SDL_LockMutex(ar->lock);
+    ar->pending = 0;
+    ar->request++;
+    ar->resultReady = 0;
+    SDL_AtomicSet(&ar->cancel, 1);
+    SDL_UnlockMutex(ar->lock);
+}
+
+int asyncRouteBusy(AsyncRoute* ar) {
+    SDL_LockMutex(ar->lock);
+    int busy = ar->pending || ar->running;
+    SDL_UnlockMutex(ar->lock);
+    return busy;
+}
+
+int asyncRouteTake(AsyncRoute* ar, RoutePath* out, int* found) {
+    SDL_LockMutex(ar->lock);
+    int ready = ar->resultReady;
+    if (ready) {
+        *out = ar->result;
+        *found = ar->resultFound;
+        ar->result.cells = NULL;
+        clearPath(&ar->result);
+        ar->resultReady = 0;
+    }
+    SDL_UnlockMutex(ar->lock);
+    return ready;
+}
+
+int asyncRoutePollProgress(AsyncRoute* ar, RouteProgress* progress) {
+    SDL_LockMutex(ar->lock);
+    int fresh = ar->snap.serial != progress->serial;
+    if (fresh) {
+        const RouteProgress* s = &ar->snap;
+        progress->frontier = (GridPos*)realloc(progress->frontier, sizeof(GridPos) * (s->frontierLen > 0 ? s->frontierLen : 1));
+        memcpy(progress->frontier, s->frontier, sizeof(GridPos) * s->frontierLen);
+        progress->frontierLen = s->frontierLen;
+        clearPath(&progress->partial);
+        progress->partial = s->partial;
+        if (s->partial.len > 0) {
+            progress->partial.cells = (GridPos*)malloc(sizeof(GridPos) * s->partial.len);
+            memcpy(progress->partial.cells, s->partial.cells, sizeof(GridPos) * s->partial.len);
+        }
+        progress->expanded = s->expanded;
+        progress->serial = s->serial;
+    }
+    SDL_UnlockMutex(ar->lock);
+    return fresh;
+}
+
+void routeProgressFree(RouteProgress* progress) {
+    free(progress->frontier);
+    progress->frontier = NULL;
+    progress->frontierLen = 0;
+    clearPath(&progress->partial);
+}
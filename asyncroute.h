@@ -0,0 +1,41 @@
+#ifndef ASYNCROUTE_H
+#define ASYNCROUTE_H
+
+// Route planning for the viewer (storm2.c) off the event loop. A worker thread owns a
+// Planner; a request returns at once and the finished route is picked up by a later
+// frame. A newer request or a cancel stops the running search at its next progress
+// poll. The planner keeps what it searched, so moving A (or the weather) repairs the
+// last route instead of searching again, even after a stop; moving B starts over.
+// While a search runs the worker publishes snapshots of its frontier and of the best
+// partial route, a few dozen times a second at most.
+#include "route.h"
+
+#define ASYNC_FRONTIER_MAX 2048
+
+typedef struct AsyncRoute AsyncRoute;
+
+typedef struct {
+    GridPos* frontier;      // sample of the open queue, at most ASYNC_FRONTIER_MAX cells
+    int frontierLen;
+    RoutePath partial;      // from the last cell expanded to the goal, len 0 if none
+    int expanded;           // so far in this request
+    unsigned serial;        // of the snapshot copied, 0 before the first
+} RouteProgress;
+
+AsyncRoute* asyncRouteCreate(void);
+void asyncRouteFree(AsyncRoute* ar);
+// Plans from start to goal (both already on water), superseding any request in flight.
+void asyncRouteStart(AsyncRoute* ar, GridPos start, GridPos goal);
+// Drops the request in flight; no result is delivered for it.
+void asyncRouteCancel(AsyncRoute* ar);
+// 1 while a request is queued or being planned.
+int asyncRouteBusy(AsyncRoute* ar);
+// Hands over the result of the latest request once it is done: returns 1 and sets
+// *found; *out receives the route pulled taut (see smoothPath), caller frees it.
+int asyncRouteTake(AsyncRoute* ar, RoutePath* out, int* found);
+// Copies the newest snapshot of the running request into progress if it differs from
+// the one it holds; returns 1 if it did. Free the copies with routeProgressFree().
+int asyncRoutePollProgress(AsyncRoute* ar, RouteProgress* progress);
+void routeProgressFree(RouteProgress* progress);
+
+#endif
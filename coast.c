@@ -0,0 +1,166 @@
+#include "searchctx.h"
+#include "parallel.h"
+#include <stdlib.h>
+
+// Coastal padding from an exact Euclidean distance transform of the land mask.
+// A vertical pass gives every cell its distance to the nearest land cell in its own
+// column; a pass along each row then combines those into the squared distance to the
+// nearest land cell anywhere and marks padding directly. Both passes are independent
+// per column/row, are split across threads, and walk contiguous rows so the inner
+// loops vectorize.
+//
+// Only distances up to the margin matter, so column distances are capped just past
+// it. For the usual margins of a few cells the row pass is a min over the window
+// |dx| <= margin; wide margins use the lower envelope of parabolas (Felzenszwalb &
+// Huttenlocher), which is linear per row whatever the margin. On a wrapping chart
+// (setMapWraps) the row pass also looks across the seam.
+//
+// The chart is Mercator, so a cell covers nmPerCell() * cos(latitude) of sea and a
+// margin in nm is wider in cells the further a row is from the equator. Each row is
+// padded with its own radius; distances are measured in cells, which Mercator being
+// conformal keeps true in every direction near the coast.
+
+#define WINDOW_LIMIT 16     // widest margin, in cells, done with the windowed row pass
+// Source-image row of the equator on assets/temp1.png, a full-world Mercator chart
+// (fitted to the coastline; the viewer's pixelToLat() calibration is not usable here).
+#define MERCATOR_EQUATOR_Y 3951.0f
+#define MAX_MARGIN_LAT 85.0f    // rows nearer the poles are padded as if at this latitude
+
+static float marginNm = 0.0f;
+
+void setCoastalMargin(float nm) { marginNm = nm; }
+float coastalMargin() { return marginNm; }
+
+// The chart is taken to span 360 degrees of longitude; a cell is measured at the equator.
+float nmPerCell() { return gridW > 0 ? 21600.0f / gridW : 0.0f; }
+
+// Nautical miles a cell of row r spans: the equatorial size shrunk by cos(latitude),
+// the latitude following from the Mercator radius of gridW / 2pi cells.
+float nmPerCellAtRow(int r) {
+    if (gridW <= 0) return 0.0f;
+    float radius = gridW / (2.0f * (float)M_PI);
+    float y = MERCATOR_EQUATOR_Y / GRID_SCALE - (r + 0.5f);
+    float lat = 2.0f * atanf(expf(y / radius)) - (float)M_PI / 2.0f;
+    float maxLat = MAX_MARGIN_LAT * (float)M_PI / 180.0f;
+    return nmPerCell() * cosf(fabsf(lat) < maxLat ? lat : maxLat);
+}
+
+typedef struct {
+    uint16_t* column;   // distance to land along the column, capped at cap
+    int cap;            // widest margin + 1: anything this far is simply "far"
+    int radius;         // widest row's margin rounded down, in cells
+    int* rowRadius;     // per row
+    int32_t* rowLimit;  // padding where squared distance <= rowLimit[r]
+} CoastJob;
+
+static void columnPass(void* arg, int c0, int c1) {
+    CoastJob* job = (CoastJob*)arg;
+    uint16_t cap = (uint16_t)job->cap;
+    for (int r = 0; r < gridH; r++) {
+        const unsigned char* restrict land = collisionGrid + r * gridW;
+        uint16_t* restrict cur = job->column + r * gridW;
+        const uint16_t* restrict prev = cur - gridW;
+        if (r == 0) for (int c = c0; c < c1; c++) cur[c] = land[c] == 1 ? 0 : cap;
+        else for (int c = c0; c < c1; c++) cur[c] = land[c] == 1 ? 0 : (prev[c] < cap ? prev[c] + 1 : cap);
+    }
+    for (int r = gridH - 2; r >= 0; r--) {
+        uint16_t* restrict cur = job->column + r * gridW;
+        const uint16_t* restrict next = cur + gridW;
+        for (int c = c0; c < c1; c++) cur[c] = next[c] + 1 < cur[c] ? next[c] + 1 : cur[c];
+    }
+}
+
+// Windowed row pass: squared distance = min over |dx| <= radius of dx^2 + column^2.
+static void rowPassWindow(void* arg, int r0, int r1) {
+    CoastJob* job = (CoastJob*)arg;
+    int32_t* restrict best = (int32_t*)malloc(sizeof(int32_t) * gridW);
+    int32_t* restrict sq = (int32_t*)malloc(sizeof(int32_t) * gridW);
+    for (int r = r0; r < r1; r++) {
+        const uint16_t* col = job->column + r * gridW;
+        for (int c = 0; c < gridW; c++) { sq[c] = (int32_t)col[c] * col[c]; best[c] = sq[c]; }
+        int32_t limit = job->rowLimit[r];
+        for (int dx = 1; dx <= job->rowRadius[r] && dx < gridW; dx++) {
+            int32_t d2 = dx * dx;
+            for (int c = 0; c + dx < gridW; c++)
+                best[c] = sq[c + dx] + d2 < best[c] ? sq[c + dx] + d2 : best[c];
+            for (int c = dx; c < gridW; c++)
+                best[c] = sq[c - dx] + d2 < best[c] ? sq[c - dx] + d2 : best[c];
+            if (!wrapColumns) continue;
+            for (int c = gridW - dx; c < gridW; c++)
+                best[c] = sq[c + dx - gridW] + d2 < best[c] ? sq[c + dx - gridW] + d2 : best[c];
+            for (int c = 0; c < dx; c++)
+                best[c] = sq[c - dx + gridW] + d2 < best[c] ? sq[c - dx + gridW] + d2 : best[c];
+        }
+        unsigned char* cells = collisionGrid + r * gridW;
+        for (int c = 0; c < gridW; c++)
+            if (cells[c] == 0 && best[c] <= limit) cells[c] = 2;
+    }
+    free(best); free(sq);
+}
+
+// Lower-envelope row pass for wide margins. A wrapping row is extended by the margin
+// on both sides with the columns from across the seam.
+static void rowPassEnvelope(void* arg, int r0, int r1) {
+    CoastJob* job = (CoastJob*)arg;
+    int pad = wrapColumns ? (job->radius < gridW ? job->radius : gridW) : 0, n = gridW + 2 * pad;
+    double* f = (double*)malloc(sizeof(double) * n);
+    double* z = (double*)malloc(sizeof(double) * (n + 1));
+    int* v = (int*)malloc(sizeof(int) * n);
+    for (int r = r0; r < r1; r++) {
+        const uint16_t* col = job->column + r * gridW;
+        unsigned char* cells = collisionGrid + r * gridW - pad;
+        for (int q = 0; q < n; q++) {
+            int c = (q - pad + gridW) % gridW;
+            f[q] = (double)col[c] * col[c];
+        }
+        // Lower envelope of the parabolas (x - q)^2 + f[q].
+        int k = 0;
+        v[0] = 0; z[0] = -1e300; z[1] = 1e300;
+        for (int q = 1; q < n; q++) {
+            double s;
+            for (;;) {
+                int p = v[k];
+                s = ((f[q] + (double)q * q) - (f[p] + (double)p * p)) / (2.0 * (q - p));
+                if (s > z[k]) break;    // z[0] is -inf, so k never underflows
+                k--;
+            }
+            k++;
+            v[k] = q; z[k] = s; z[k + 1] = 1e300;
+        }
+        k = 0;
+        double limit = job->rowLimit[r];
+        for (int q = pad; q < pad + gridW; q++) {
+            while (z[k + 1] < q) k++;
+            double dq = q - v[k];
+            if (cells[q] == 0 && dq * dq + f[v[k]] <= limit) cells[q] = 2;
+        }
+    }
+    free(f); free(z); free(v);
+}
+
+void markCoastalPadding() {
+    PERF_TIMER(t0);
+    CoastJob job;
+    job.rowRadius = (int*)malloc(sizeof(int) * gridH);
+    job.rowLimit = (int32_t*)malloc(sizeof(int32_t) * gridH);
+    job.radius = 1;
+    for (int r = 0; r < gridH; r++) {
+        if (marginNm > 0) {
+            float margin = marginNm / nmPerCellAtRow(r);
+            if (margin > 30000) margin = 30000;
+            job.rowLimit[r] = (int32_t)(margin * margin);
+            job.rowRadius[r] = (int)margin;
+        } else {
+            // No margin set: the one-cell ring (8-neighbourhood) of the original 3x3 pass.
+            job.rowLimit[r] = 2;
+            job.rowRadius[r] = 1;
+        }
+        if (job.rowRadius[r] > job.radius) job.radius = job.rowRadius[r];
+    }
+    job.cap = job.radius + 1;
+    job.column = (uint16_t*)malloc(sizeof(uint16_t) * gridW * gridH);
+    parallelFor(gridW, columnPass, &job);
+    parallelFor(gridH, job.radius <= WINDOW_LIMIT ? rowPassWindow : rowPassEnvelope, &job);
+    free(job.column); free(job.rowRadius); free(job.rowLimit);
+    PERF_PHASE(PERF_COAST, t0);
+}
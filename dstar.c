@@ -0,0 +1,366 @@
+#include "searchctx.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Incremental replanning with D* Lite (Koenig & Likhachev). The search runs backward
+// from the goal, so g(s) is the cost from s to the goal and stays valid when the
+// start moves: a moved start only raises km, the offset that keeps the old queue keys
+// lower bounds. Between calls the planner keeps g/rhs and the cost field it planned
+// on; the next call diffs that against costField, and only the cells whose cost changed
+// (weather, padding, land) and whatever depends on them are re-expanded.
+// A new goal discards the search state (the tree is rooted at the goal).
+// A repair is not always cheaper than starting over: a storm across a plan made in
+// calm weather invalidates nearly every g, and each such cell is expanded twice (raised,
+// then lowered again) over a frontier the new weather widens besides. The planner starts
+// over at once when the cost diff requeues more than PLAN_REPAIR_SEEDS of the cells the
+// last plan from scratch expanded (the bench's storms requeue about 6%, repairs that pay
+// off under 1%), and a repair that still spends more than PLAN_REPAIR_BUDGET of that
+// plan's expansions is abandoned for a clean search too.
+// Edge costs are the grid searches' own: the step plus the entered cell's costField
+// entry, so routes cost the same as an optimal (octile) astarSearch(). The queue is a
+// binary heap with lazy deletion. Each cell remembers the key of its live entry and is
+// only pushed again when its key drops below that; an entry that surfaces with a key
+// that has since grown is requeued, and superseded entries are dropped.
+// The queue holds every inconsistent cell, so a search stopped by its progress hook is
+// simply continued by the next call: nothing needs undoing.
+
+#define PLAN_PROGRESS_EXPANSIONS 4096
+#define PLAN_REPAIR_SEEDS 0.03f
+#define PLAN_REPAIR_BUDGET 0.5f
+// g is summed one float step at a time while the octile term is computed in one go,
+// so on a long route h can come out a rounding error above the true remaining cost.
+// Keys are compared exactly, and an h too high by 0.005 is enough to end a repair
+// with the start still at INFINITY or to churn an initial plan through tens of
+// millions of re-expansions. Shaving 0.1% keeps h below any summed cost, whose
+// rounding stays near 1e-4 of it even across an ocean.
+#define PLAN_H_SCALE 0.999f
+
+typedef struct { float k1, k2; int idx; } PlanKey;
+
+struct Planner {
+    int cells;
+    float* g;
+    float* rhs;
+    float* queued;          // k1 of the cell's live heap entry, INFINITY if none
+    uint32_t* stamp;        // g/rhs/queued are INFINITY unless stamp == generation
+    uint32_t generation;
+    uint16_t* cost;         // costField as of the last call
+    int* changed;
+    int changedCap;
+    PlanKey* heap;
+    int heapLen, heapCap;
+    int goal, start, last;  // last: the start km was last brought up to date for
+    float km;
+    int wraps;              // wrapColumns the search state was built under
+    int lastExpanded;       // -1 until the first expansion since a reset
+    int stopped;
+    int planned;            // the search since the last reset has reached a route
+    int fullExpanded;       // expansions that took, over stopped calls too
+    int repairExpanded;     // expansions of the current repair, likewise
+    long long pushes, pops;     // this call's queue traffic, for perf.h
+    int peak;
+    PlannerProgress progress;
+    void* progressUser;
+};
+
+Planner* plannerCreate() {
+    Planner* p = (Planner*)calloc(1, sizeof(Planner));
+    if (p) p->goal = p->lastExpanded = -1;
+    return p;
+}
+
+void plannerFree(Planner* p) {
+    if (!p) return;
+    free(p->g); free(p->rhs); free(p->queued); free(p->stamp); free(p->cost);
+    free(p->changed); free(p->heap);
+    free(p);
+}
+
+static inline float gOf(const Planner* p, int i) { return p->stamp[i] == p->generation ? p->g[i] : INFINITY; }
+static inline float rhsOf(const Planner* p, int i) { return p->stamp[i] == p->generation ? p->rhs[i] : INFINITY; }
+
+static inline void touch(Planner* p, int i) {
+    if (p->stamp[i] != p->generation) { p->stamp[i] = p->generation; p->g[i] = p->rhs[i] = p->queued[i] = INFINITY; }
+}
+
+static inline float octile(int a, int b) {
+    int dr = abs(a / gridW - b / gridW), dc = columnGap(a % gridW, b % gridW);
+    return PLAN_H_SCALE * (dr > dc ? (dr - dc) + STEP_DIAGONAL * dc : (dc - dr) + STEP_DIAGONAL * dr);
+}
+
+static inline PlanKey keyOf(const Planner* p, int i) {
+    float g = gOf(p, i), rhs = rhsOf(p, i), m = g < rhs ? g : rhs;
+    PlanKey k = { m + octile(p->start, i) + p->km, m, i };
+    return k;
+}
+
+static inline int keyLess(PlanKey a, PlanKey b) {
+    return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+}
+
+static void heapPush(Planner* p, PlanKey k) {
+    if (p->heapLen == p->heapCap) {
+        p->heapCap = p->heapCap ? p->heapCap * 2 : 4096;
+        p->heap = (PlanKey*)realloc(p->heap, sizeof(PlanKey) * p->heapCap);
+    }
+    int i = p->heapLen++;
+    PERF_ONLY(p->pushes++; if (p->heapLen > p->peak) p->peak = p->heapLen;)
+    while (i > 0) {
+        int up = (i - 1) / 2;
+        if (!keyLess(k, p->heap[up])) break;
+        p->heap[i] = p->heap[up];
+        i = up;
+    }
+    p->heap[i] = k;
+}
+
+// Queues u at its current key unless its live entry is already at or below it.
+static void enqueue(Planner* p, int u) {
+    PlanKey k = keyOf(p, u);
+    touch(p, u);
+    if (k.k1 >= p->queued[u]) return;
+    p->queued[u] = k.k1;
+    heapPush(p, k);
+}
+
+static PlanKey heapPop(Planner* p) {
+    PlanKey top = p->heap[0], last = p->heap[--p->heapLen];
+    PERF_ONLY(p->pops++;)
+    int i = 0, n = p->heapLen;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && keyLess(p->heap[child + 1], p->heap[child])) child++;
+        if (!keyLess(p->heap[child], last)) break;
+        p->heap[i] = p->heap[child];
+        i = child;
+    }
+    if (n > 0) p->heap[i] = last;
+    return top;
+}
+
+// Cost of the move from u in direction k, INFINITY off the grid or touching land.
+static inline float edgeCost(const Planner* p, int u, int k, int* v) {
+    int r = u / gridW + neighbourDr[k], c = stepColumn(u % gridW + neighbourDc[k]);
+    if (r < 0 || r >= gridH || c < 0) return INFINITY;
+    *v = r * gridW + c;
+    if (p->cost[u] == COST_LAND || p->cost[*v] == COST_LAND) return INFINITY;
+    return neighbourStep[k] + p->cost[*v] * (1.0f / COST_SCALE);
+}
+
+static float bestSuccessor(const Planner* p, int u) {
+    float best = INFINITY;
+    for (int k = 0; k < 8; k++) {
+        int v;
+        float c = edgeCost(p, u, k, &v);
+        if (c < INFINITY && c + gOf(p, v) < best) best = c + gOf(p, v);
+    }
+    return best;
+}
+
+static void updateVertex(Planner* p, int u) {
+    if (u != p->goal) {
+        float rhs = bestSuccessor(p, u);
+        if (rhs != rhsOf(p, u)) { touch(p, u); p->rhs[u] = rhs; }
+    }
+    if (gOf(p, u) != rhsOf(p, u)) enqueue(p, u);
+}
+
+// Expands at most limit cells; a count of limit means the search may not be done.
+static int computeShortestPath(Planner* p, int limit) {
+    int expanded = 0;
+    while (p->heapLen > 0) {
+        PlanKey top = p->heap[0];
+        int u = top.idx;
+        // Superseded by a lower entry, or settled since it was queued.
+        if (top.k1 != p->queued[u] || gOf(p, u) == rhsOf(p, u)) {
+            heapPop(p);
+            if (top.k1 == p->queued[u]) p->queued[u] = INFINITY;
+            continue;
+        }
+        if (!keyLess(top, keyOf(p, p->start)) && rhsOf(p, p->start) <= gOf(p, p->start)) break;
+        heapPop(p);
+        p->queued[u] = INFINITY;
+        PlanKey now = keyOf(p, u);
+        if (keyLess(top, now)) { enqueue(p, u); continue; }
+        expanded++;
+        p->lastExpanded = u;
+        if (p->g[u] > p->rhs[u]) {
+            // Overconsistent: settle u and offer it to its neighbours.
+            p->g[u] = p->rhs[u];
+            for (int k = 0; k < 8; k++) {
+                int s;
+                float c = edgeCost(p, u, k, &s);    // the grid is 8-connected both ways
+                if (c == INFINITY || s == p->goal) continue;
+                // Moving s -> u costs the step plus u's cell.
+                float via = neighbourStep[k] + p->cost[u] * (1.0f / COST_SCALE) + p->g[u];
+                if (via < rhsOf(p, s)) { touch(p, s); p->rhs[s] = via; enqueue(p, s); }
+            }
+        } else {
+            // Underconsistent: u got dearer; whoever relied on it looks again.
+            float old = p->g[u];
+            p->g[u] = INFINITY;
+            updateVertex(p, u);
+            for (int k = 0; k < 8; k++) {
+                int s;
+                if (edgeCost(p, u, k, &s) == INFINITY || s == p->goal) continue;
+                float via = neighbourStep[k] + p->cost[u] * (1.0f / COST_SCALE) + old;
+                if (rhsOf(p, s) == via) updateVertex(p, s);
+            }
+        }
+        if (p->progress && expanded % PLAN_PROGRESS_EXPANSIONS == 0 && p->progress(p->progressUser, p, expanded)) {
+            p->stopped = 1;
+            break;
+        }
+        if (expanded == limit) break;
+    }
+    return expanded;
+}
+
+static void resetPlanner(Planner* p, int goal) {
+    int cells = gridW * gridH;
+    if (p->cells != cells) {
+        free(p->g); free(p->rhs); free(p->queued); free(p->stamp); free(p->cost);
+        p->g = (float*)malloc(sizeof(float) * cells);
+        p->rhs = (float*)malloc(sizeof(float) * cells);
+        p->queued = (float*)malloc(sizeof(float) * cells);
+        p->stamp = (uint32_t*)calloc(cells, sizeof(uint32_t));
+        p->cost = (uint16_t*)malloc(sizeof(uint16_t) * cells);
+        p->cells = cells;
+        p->generation = 0;
+    }
+    if (++p->generation == 0) {
+        memset(p->stamp, 0, sizeof(uint32_t) * cells);
+        p->generation = 1;
+    }
+    memcpy(p->cost, costField, sizeof(uint16_t) * cells);
+    p->heapLen = 0;
+    p->km = 0;
+    p->goal = goal;
+    p->wraps = wrapColumns;
+    p->last = p->start;
+    p->lastExpanded = -1;
+    p->planned = p->fullExpanded = 0;
+    touch(p, goal);
+    p->rhs[goal] = 0;
+    enqueue(p, goal);
+}
+
+// Picks up cost changes since the last call and requeues the cells they affect;
+// returns how many were queued.
+static int applyCostChanges(Planner* p) {
+    int n = 0, cells = p->cells, queued = p->heapLen;
+    // Compare a block at a time; most of the field is untouched between calls.
+    for (int base = 0; base < cells; base += 64) {
+        int len = cells - base < 64 ? cells - base : 64;
+        if (!memcmp(p->cost + base, costField + base, sizeof(uint16_t) * len)) continue;
+        for (int i = base; i < base + len; i++) {
+            if (p->cost[i] == costField[i]) continue;
+            p->cost[i] = costField[i];
+            if (n == p->changedCap) {
+                p->changedCap = p->changedCap ? p->changedCap * 2 : 1024;
+                p->changed = (int*)realloc(p->changed, sizeof(int) * p->changedCap);
+            }
+            p->changed[n++] = i;
+        }
+    }
+    // A cell's cost is on every edge into it (and, for land, out of it).
+    for (int j = 0; j < n; j++) {
+        int v = p->changed[j];
+        updateVertex(p, v);
+        int r = v / gridW, c = v % gridW;
+        for (int k = 0; k < 8; k++) {
+            int nr = r + neighbourDr[k], nc = stepColumn(c + neighbourDc[k]);
+            if (nr >= 0 && nr < gridH && nc >= 0) updateVertex(p, nr * gridW + nc);
+        }
+    }
+    return p->heapLen - queued;
+}
+
+// Follows the cheapest successor from cell s down to the goal.
+static int followRoute(const Planner* p, int s, float cost, RoutePath* out) {
+    int t = p->goal, len = 1, cap = 256;
+    GridPos* cells = (GridPos*)malloc(sizeof(GridPos) * cap);
+    cells[0] = (GridPos){ s / gridW, s % gridW };
+    for (int u = s; u != t; len++) {
+        int next = -1;
+        float best = INFINITY;
+        for (int k = 0; k < 8; k++) {
+            int v;
+            float c = edgeCost(p, u, k, &v);
+            if (c < INFINITY && c + gOf(p, v) < best) { best = c + gOf(p, v); next = v; }
+        }
+        if (next < 0 || len == p->cells) { free(cells); return 0; }
+        if (len == cap) { cap *= 2; cells = (GridPos*)realloc(cells, sizeof(GridPos) * cap); }
+        cells[len] = (GridPos){ next / gridW, next % gridW };
+        u = next;
+    }
+    out->cells = cells;
+    out->len = len;
+    out->cost = cost;
+    out->hours = routeHours(out);
+    return 1;
+}
+
+int plannerRoute(Planner* p, GridPos start, GridPos goal, RoutePath* out) {
+    out->cells = NULL; out->len = 0; out->cost = 0; out->expanded = 0; out->hours = 0;
+    if (!collisionGrid || !costField) return 0;
+    if (start.r < 0 || start.r >= gridH || start.c < 0 || start.c >= gridW) return 0;
+    if (goal.r < 0 || goal.r >= gridH || goal.c < 0 || goal.c >= gridW) return 0;
+    int s = start.r * gridW + start.c, t = goal.r * gridW + goal.c;
+    if (costField[s] == COST_LAND || costField[t] == COST_LAND) return 0;
+
+    PERF_TIMER(t0);
+    PERF_ONLY(p->pushes = p->pops = 0; p->peak = 0;)
+    p->start = s;
+    if (p->goal != t || p->cells != gridW * gridH || p->wraps != wrapColumns) resetPlanner(p, t);
+    else {
+        if (!p->stopped) p->repairExpanded = 0;     // else this call finishes the last one
+        p->km += octile(p->last, s);
+        p->last = s;
+        if (applyCostChanges(p) > p->fullExpanded * PLAN_REPAIR_SEEDS && p->planned) resetPlanner(p, t);
+    }
+    p->stopped = 0;
+    int limit = p->planned ? (int)(p->fullExpanded * PLAN_REPAIR_BUDGET) - p->repairExpanded : INT_MAX;
+    int expanded = limit > 0 ? computeShortestPath(p, limit) : 0;
+    if (!p->planned) p->fullExpanded += expanded;
+    else if (!p->stopped && expanded >= limit) {
+        // The repair is redoing most of the plan: a clean search is cheaper.
+        resetPlanner(p, t);
+        int full = computeShortestPath(p, INT_MAX);
+        p->fullExpanded = full;
+        expanded += full;
+    }
+    else p->repairExpanded += expanded;
+    if (!p->stopped) p->planned = 1;
+    out->expanded = expanded;
+    PERF_SEARCH(out->expanded, p->pushes, p->pops, p->peak, t0);
+    if (p->stopped || rhsOf(p, s) == INFINITY) return 0;
+    return followRoute(p, s, rhsOf(p, s), out);
+}
+
+void plannerSetProgress(Planner* p, PlannerProgress fn, void* user) {
+    p->progress = fn;
+    p->progressUser = user;
+}
+
+int plannerStopped(const Planner* p) { return p->stopped; }
+
+int plannerFrontier(const Planner* p, GridPos* out, int max) {
+    if (max <= 0 || p->heapLen == 0) return 0;
+    int stride = (p->heapLen + max - 1) / max, n = 0;
+    for (int i = 0; i < p->heapLen && n < max; i += stride) {
+        int u = p->heap[i].idx;
+        if (p->heap[i].k1 != p->queued[u]) continue;     // superseded entry
+        out[n++] = (GridPos){ u / gridW, u % gridW };
+    }
+    return n;
+}
+
+int plannerPartialRoute(const Planner* p, RoutePath* out) {
+    out->cells = NULL; out->len = 0; out->cost = 0; out->expanded = 0; out->hours = 0;
+    int u = p->lastExpanded;
+    if (u < 0 || p->goal < 0 || gOf(p, u) == INFINITY) return 0;
+    return followRoute(p, u, gOf(p, u), out);
+}
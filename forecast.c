@@ -0,0 +1,406 @@
+#include "searchctx.h"
+#include "mapfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Time-dependent routing. A timed query is plain A* over cells, not over (cell, time)
+// states: every cell keeps one label, the cheapest path found to it, and that path's
+// arrival hour picks the forecast step its neighbours are charged from. With one speed
+// and no waiting this keeps the search the size of an untimed one (4 more bytes a cell
+// for the arrival hour); the price is that a dearer path reaching a cell earlier, and
+// so seeing different weather further on, is not kept alongside it.
+// Storm penalties are never negative in any step, so the octile and landmark bounds
+// (computed without weather) stay admissible.
+//
+// The forecast is a cube of wind speeds, one byte a cell per step, cut into
+// CUBE_TILE x CUBE_TILE tiles. A tile whose cells all hold the same byte (calm or
+// ambient sea) lives in its directory entry alone; any other tile is one page of the
+// data area. Cubes built in memory (buildForecast, the importers) and cube files share
+// the layout; loadForecast() maps the file, so only the tiles a search actually reads
+// are ever paged in.
+
+#define CUBE_VERSION 1
+#define CUBE_SHIFT 6
+#define CUBE_TILE (1 << CUBE_SHIFT)     // 64x64 cells: 4 KB, a page
+#define CUBE_UNIFORM 0x80000000u        // directory entry holds the tile's only value
+#define CUBE_KTS_PER_UNIT 0.5f          // 0 to 127.5 kts
+#define CUBE_PAGE 4096
+
+typedef struct {
+    char magic[4];              // "WXC\0"
+    uint32_t version;
+    int32_t gridW, gridH;
+    int32_t mapWidth, mapHeight;    // with the grid size, pins the lat/lon calibration
+    int32_t steps;
+    float stepHours;
+    float ktsPerUnit;           // wind = byte * ktsPerUnit
+    int32_t tilesX, tilesY;
+    uint32_t dataTiles;
+    uint32_t dataOffset;        // page-aligned start of the tiles
+} CubeHeader;
+
+static CubeHeader cube;                     // steps == 0: no forecast
+static const uint32_t* directory = NULL;    // [step][tileRow][tileCol]
+static const unsigned char* tiles = NULL;
+static uint32_t* ownDirectory = NULL;       // a cube built in memory
+static unsigned char* ownTiles = NULL;
+static uint32_t tileCapacity = 0;
+static const void* cubeMapping = NULL;      // a mapped cube file
+static size_t cubeMappingSize = 0;
+static uint16_t costLut[2][256];            // cost units per wind byte: [0] open water, [1] padding
+static float knots = 0.0f;
+
+void freeForecast() {
+    if (cubeMapping) unmapFile(cubeMapping, cubeMappingSize);
+    cubeMapping = NULL; cubeMappingSize = 0;
+    free(ownDirectory); ownDirectory = NULL;
+    free(ownTiles); ownTiles = NULL;
+    tileCapacity = 0;
+    directory = NULL; tiles = NULL;
+    memset(&cube, 0, sizeof(cube));
+}
+
+int forecastSteps() { return cube.steps; }
+float forecastStepHours() { return cube.stepHours; }
+
+static inline unsigned char cubeValue(int step, int r, int c) {
+    uint32_t e = directory[(step * cube.tilesY + (r >> CUBE_SHIFT)) * cube.tilesX + (c >> CUBE_SHIFT)];
+    if (e & CUBE_UNIFORM) return (unsigned char)e;
+    return tiles[((size_t)e << (2 * CUBE_SHIFT)) + ((r & (CUBE_TILE - 1)) << CUBE_SHIFT) + (c & (CUBE_TILE - 1))];
+}
+
+static int stepAt(float hours) {
+    int s = (int)(hours / cube.stepHours + 0.5f);
+    return s < 0 ? 0 : s >= cube.steps ? cube.steps - 1 : s;
+}
+
+float forecastWind(float hours, int r, int c) {
+    if (!cube.steps || r < 0 || r >= gridH || c < 0 || c >= gridW) return 0;
+    return cubeValue(stepAt(hours), r, c) * cube.ktsPerUnit;
+}
+
+// --- Building ---
+static int beginCube(int steps, float stepHours) {
+    freeForecast();
+    if (steps <= 0 || stepHours <= 0 || !collisionGrid) return 0;
+    memcpy(cube.magic, "WXC", 4);
+    cube.version = CUBE_VERSION;
+    cube.gridW = gridW; cube.gridH = gridH;
+    cube.mapWidth = mapWidth; cube.mapHeight = mapHeight;
+    cube.stepHours = stepHours;
+    cube.ktsPerUnit = CUBE_KTS_PER_UNIT;
+    cube.tilesX = (gridW + CUBE_TILE - 1) >> CUBE_SHIFT;
+    cube.tilesY = (gridH + CUBE_TILE - 1) >> CUBE_SHIFT;
+    ownDirectory = (uint32_t*)calloc((size_t)steps * cube.tilesX * cube.tilesY, sizeof(uint32_t));
+    directory = ownDirectory;
+    return ownDirectory != NULL;
+}
+
+static inline unsigned char quantize(float kts) {
+    float q = kts * (1.0f / CUBE_KTS_PER_UNIT) + 0.5f;
+    return q <= 0 ? 0 : q >= 255 ? 255 : (unsigned char)q;
+}
+
+// Quantizes a gridW*gridH wind field into the next step.
+static int addStep(const float* wind) {
+    unsigned char tile[CUBE_TILE * CUBE_TILE];
+    uint32_t* entry = ownDirectory + (size_t)cube.steps * cube.tilesX * cube.tilesY;
+    for (int ty = 0; ty < cube.tilesY; ty++) {
+        for (int tx = 0; tx < cube.tilesX; tx++, entry++) {
+            int r0 = ty << CUBE_SHIFT, c0 = tx << CUBE_SHIFT;
+            int rows = gridH - r0 < CUBE_TILE ? gridH - r0 : CUBE_TILE;
+            int cols = gridW - c0 < CUBE_TILE ? gridW - c0 : CUBE_TILE;
+            unsigned char first = quantize(wind[r0 * gridW + c0]);
+            int uniform = 1;
+            memset(tile, first, sizeof(tile));     // cells past the grid edge copy the first
+            for (int r = 0; r < rows; r++) {
+                const float* src = wind + (r0 + r) * gridW + c0;
+                unsigned char* dst = tile + (r << CUBE_SHIFT);
+                for (int c = 0; c < cols; c++) { dst[c] = quantize(src[c]); uniform &= dst[c] == first; }
+            }
+            if (uniform) { *entry = CUBE_UNIFORM | first; continue; }
+            if (cube.dataTiles == tileCapacity) {
+                uint32_t capacity = tileCapacity ? tileCapacity * 2 : 64;
+                unsigned char* grown = (unsigned char*)realloc(ownTiles, (size_t)capacity << (2 * CUBE_SHIFT));
+                if (!grown) return 0;
+                ownTiles = grown; tileCapacity = capacity;
+            }
+            memcpy(ownTiles + ((size_t)cube.dataTiles << (2 * CUBE_SHIFT)), tile, sizeof(tile));
+            *entry = cube.dataTiles++;
+        }
+    }
+    tiles = ownTiles;
+    cube.steps++;
+    return 1;
+}
+
+static void finishCube() {
+    for (int q = 0; q < 256; q++) {
+        costLut[0][q] = cellCost(0, q * cube.ktsPerUnit);
+        costLut[1][q] = cellCost(2, q * cube.ktsPerUnit);
+    }
+}
+
+// Imported and mapped forecasts replace the storm model: their first step becomes the
+// hour-0 weather that the untimed searches and the overlay use.
+static void adoptFirstStep() {
+    finishCube();
+    if (!weatherGrid) return;
+    for (int r = 0; r < gridH; r++)
+        for (int c = 0; c < gridW; c++) weatherGrid[r * gridW + c] = cubeValue(0, r, c) * cube.ktsPerUnit;
+    refreshDerivedGrids();
+}
+
+int buildForecast(int steps, float stepHours) {
+    if (!beginCube(steps, stepHours)) return 0;
+    float* wind = (float*)malloc(sizeof(float) * gridW * gridH);
+    if (!wind) { freeForecast(); return 0; }
+    for (int k = 0; k < steps; k++) {
+        computeWind(wind, k * stepHours);
+        if (!addStep(wind)) break;
+    }
+    free(wind);
+    finishCube();
+    return cube.steps;
+}
+
+// --- Import ---
+int importForecastRaw(const char* path, int steps, float stepHours) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    float* wind = (float*)malloc(sizeof(float) * gridW * gridH);
+    if (!wind || !beginCube(steps, stepHours)) { free(wind); fclose(f); return 0; }
+    size_t cells = (size_t)gridW * gridH;
+    for (int k = 0; k < steps && fread(wind, sizeof(float), cells, f) == cells; k++)
+        if (!addStep(wind)) break;
+    free(wind);
+    fclose(f);
+    if (!cube.steps) { freeForecast(); return 0; }
+    adoptFirstStep();
+    return cube.steps;
+}
+
+typedef struct { float hour, lat, lon, kts; } WindSample;
+
+static int compareFloat(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static int compareSampleHour(const void* a, const void* b) {
+    return compareFloat(&((const WindSample*)a)->hour, &((const WindSample*)b)->hour);
+}
+
+// Sorts and dedups values in place; returns how many remain.
+static int uniqueSorted(float* v, int n) {
+    qsort(v, n, sizeof(float), compareFloat);
+    int m = 0;
+    for (int i = 0; i < n; i++) if (m == 0 || v[i] != v[m - 1]) v[m++] = v[i];
+    return m;
+}
+
+// Index of the lattice value nearest x, or -1 if x is more than half a spacing outside.
+static int nearestIndex(const float* v, int n, float x) {
+    int lo = 0, hi = n;
+    while (lo < hi) { int mid = (lo + hi) / 2; if (v[mid] < x) lo = mid + 1; else hi = mid; }
+    if (lo == n || (lo > 0 && x - v[lo - 1] < v[lo] - x)) lo--;
+    float half = n > 1 ? (v[1] - v[0]) * 0.5f : 0.5f;
+    return x < v[0] - half || x > v[n - 1] + half ? -1 : lo;
+}
+
+int importForecastCsv(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    WindSample* samples = NULL;
+    int count = 0, capacity = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* hash = strchr(line, '#'); if (hash) *hash = '\0';
+        for (char* p = line; *p; p++) if (*p == ',' || *p == ';') *p = ' ';
+        WindSample s;
+        if (sscanf(line, "%f %f %f %f", &s.hour, &s.lat, &s.lon, &s.kts) != 4) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            WindSample* grown = (WindSample*)realloc(samples, sizeof(WindSample) * capacity);
+            if (!grown) break;
+            samples = grown;
+        }
+        samples[count++] = s;
+    }
+    fclose(f);
+    if (!count) { free(samples); return 0; }
+
+    // The samples form a regular lat/lon lattice per hour, the hours a regular series.
+    float* hours = (float*)malloc(sizeof(float) * count);
+    float* lats = (float*)malloc(sizeof(float) * count);
+    float* lons = (float*)malloc(sizeof(float) * count);
+    for (int i = 0; i < count; i++) { hours[i] = samples[i].hour; lats[i] = samples[i].lat; lons[i] = samples[i].lon; }
+    int nHours = uniqueSorted(hours, count), nLat = uniqueSorted(lats, count), nLon = uniqueSorted(lons, count);
+    float base = hours[0], stepHours = nHours > 1 ? hours[1] - hours[0] : 1.0f;
+    int steps = (int)((hours[nHours - 1] - base) / stepHours + 0.5f) + 1;
+    qsort(samples, count, sizeof(WindSample), compareSampleHour);
+
+    int* rowLattice = (int*)malloc(sizeof(int) * gridH);
+    int* colLattice = (int*)malloc(sizeof(int) * gridW);
+    for (int r = 0; r < gridH; r++) rowLattice[r] = nearestIndex(lats, nLat, pixelToLat(r * GRID_SCALE));
+    for (int c = 0; c < gridW; c++) colLattice[c] = nearestIndex(lons, nLon, pixelToLon(c * GRID_SCALE));
+    float* lattice = (float*)malloc(sizeof(float) * nLat * nLon);
+    float* wind = (float*)calloc((size_t)gridW * gridH, sizeof(float));
+
+    int ok = lattice && wind && beginCube(steps, stepHours), next = 0;
+    for (int k = 0; ok && k < steps; k++) {
+        // Hours without samples repeat the previous step; points without samples are calm.
+        if (next < count && (int)((samples[next].hour - base) / stepHours + 0.5f) == k) {
+            memset(lattice, 0, sizeof(float) * nLat * nLon);
+            for (; next < count && (int)((samples[next].hour - base) / stepHours + 0.5f) == k; next++) {
+                const WindSample* s = &samples[next];
+                lattice[nearestIndex(lats, nLat, s->lat) * nLon + nearestIndex(lons, nLon, s->lon)] = s->kts;
+            }
+            for (int r = 0; r < gridH; r++) {
+                float* row = wind + r * gridW;
+                const float* src = rowLattice[r] >= 0 ? lattice + rowLattice[r] * nLon : NULL;
+                for (int c = 0; c < gridW; c++) row[c] = src && colLattice[c] >= 0 ? src[colLattice[c]] : 0.0f;
+            }
+        }
+        ok = addStep(wind);
+    }
+    free(samples); free(hours); free(lats); free(lons);
+    free(rowLattice); free(colLattice); free(lattice); free(wind);
+    if (!ok || !cube.steps) { freeForecast(); return 0; }
+    adoptFirstStep();
+    return cube.steps;
+}
+
+// --- Cube Files ---
+int saveForecast(const char* path) {
+    if (!cube.steps) return 0;
+    CubeHeader header = cube;
+    size_t dirBytes = (size_t)cube.steps * cube.tilesX * cube.tilesY * sizeof(uint32_t);
+    header.dataOffset = (uint32_t)((sizeof(CubeHeader) + dirBytes + CUBE_PAGE - 1) / CUBE_PAGE * CUBE_PAGE);
+    static const char zeros[CUBE_PAGE];
+    size_t pad = header.dataOffset - sizeof(CubeHeader) - dirBytes;
+    size_t tileBytes = (size_t)cube.dataTiles << (2 * CUBE_SHIFT);
+
+    // Written aside and renamed over, like the compiled grid.
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(directory, 1, dirBytes, f) == dirBytes &&
+             fwrite(zeros, 1, pad, f) == pad && fwrite(tiles, 1, tileBytes, f) == tileBytes;
+    if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) remove(path);
+#endif
+    if (!ok || rename(tmp, path) != 0) { remove(tmp); return 0; }
+    return 1;
+}
+
+int loadForecast(const char* path) {
+    if (!collisionGrid) return 0;
+    size_t size = 0;
+    const void* data = mapFile(path, &size);
+    if (!data) return 0;
+    const CubeHeader* h = (const CubeHeader*)data;
+    size_t entries = 0;
+    int ok = size >= sizeof(CubeHeader) && !memcmp(h->magic, "WXC", 4) && h->version == CUBE_VERSION &&
+             h->gridW == gridW && h->gridH == gridH && h->mapWidth == mapWidth && h->mapHeight == mapHeight &&
+             h->steps > 0 && h->stepHours > 0 && h->ktsPerUnit > 0 &&
+             h->tilesX == (gridW + CUBE_TILE - 1) >> CUBE_SHIFT && h->tilesY == (gridH + CUBE_TILE - 1) >> CUBE_SHIFT;
+    if (ok) {
+        entries = (size_t)h->steps * h->tilesX * h->tilesY;
+        ok = h->dataOffset >= sizeof(CubeHeader) + entries * sizeof(uint32_t) &&
+             size == h->dataOffset + ((size_t)h->dataTiles << (2 * CUBE_SHIFT));
+    }
+    const uint32_t* dir = (const uint32_t*)(h + 1);
+    for (size_t i = 0; ok && i < entries; i++) ok = (dir[i] & CUBE_UNIFORM) || dir[i] < h->dataTiles;
+    if (!ok) { unmapFile(data, size); return 0; }
+
+    freeForecast();
+    cube = *h;
+    cubeMapping = data; cubeMappingSize = size;
+    directory = dir;
+    tiles = (const unsigned char*)data + h->dataOffset;
+    adoptFirstStep();
+    return cube.steps;
+}
+
+// --- Ship ---
+void setServiceSpeed(float speed) { knots = speed > 0 ? speed : 0.0f; }
+float serviceSpeed() { return knots; }
+
+float loadShipSpeed(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    char line[256];
+    float speed = 0;
+    if (fgets(line, sizeof(line), f)) {
+        char* sptr = strstr(line, " speed=");
+        if (sptr) speed = (float)atof(sptr + 7);
+    }
+    fclose(f);
+    if (speed > 0) setServiceSpeed(speed);
+    return speed > 0 ? speed : 0;
+}
+
+// --- Timed Search ---
+int timedSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out) {
+    int endR = goal.r, endC = goal.c;
+
+    beginSearch(ctx);
+    if (!ctx->arrival) ctx->arrival = (float*)malloc(ctx->cells * sizeof(float));
+    OpenList* openList = &ctx->openList;
+    float* gScore = ctx->g;
+    float* arrival = ctx->arrival;
+    int32_t* parent = ctx->parent;
+    uint32_t* stamp = ctx->stamp;
+    uint32_t gen = ctx->generation;
+    float hoursPerCell = nmPerCell() / knots;
+
+    int startIdx = start.r * gridW + start.c;
+    int goalIdx = endR * gridW + endC;
+    beginHeuristic(ctx, goalIdx);
+    stamp[startIdx] = gen;
+    gScore[startIdx] = 0;
+    arrival[startIdx] = ctx->departure;
+    parent[startIdx] = -1;
+    openPush(openList, startIdx, heuristic(ctx, start.r, start.c, endR, endC));
+
+    int found = 0, currIdx;
+    float currF;
+    while ((currIdx = openPop(openList, &currF)) >= 0) {
+        int currR = currIdx / gridW, currC = currIdx % gridW;
+        float currG = gScore[currIdx];
+        if (currF > currG + heuristic(ctx, currR, currC, endR, endC)) continue; // superseded duplicate
+        out->expanded++;
+        if (currIdx == goalIdx) {
+            found = 1;
+            out->cost = currG;
+            out->hours = arrival[currIdx] - ctx->departure;
+            buildPath(parent, currIdx, out);
+            break;
+        }
+
+        float currT = arrival[currIdx];
+        for (int k = 0; k < 8; k++) {
+            int nr = currR + neighbourDr[k], nc = stepColumn(currC + neighbourDc[k]);
+            if (nr < 0 || nr >= gridH || nc < 0) continue;
+            int idx = nr * gridW + nc;
+            unsigned char cell = collisionGrid[idx];
+            if (cell == 1) continue;
+            float t = currT + neighbourStep[k] * hoursPerCell;
+            uint16_t penalty = costLut[cell == 2][cubeValue(stepAt(t), nr, nc)];
+
+            float tentativeG = currG + (neighbourStep[k] + penalty * (1.0f / COST_SCALE));
+            if (stamp[idx] != gen || tentativeG < gScore[idx]) {
+                stamp[idx] = gen;
+                gScore[idx] = tentativeG;
+                arrival[idx] = t;
+                parent[idx] = currIdx;
+                openPush(openList, idx, tentativeG + heuristic(ctx, nr, nc, endR, endC));
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,105 @@
+#include "searchctx.h"
+#include "mapfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compiled collision grid: a fixed header followed by gridW*gridH cells (0 water,
+// 1 land, 2 padding), exactly as createCollisionGrid() leaves them. Loading is a
+// mapping plus a few comparisons, so a restart skips the PNG decode and the padding
+// pass, and every process routing on the same chart shares one copy of the cells.
+
+#define GRID_FILE_VERSION 5
+
+typedef struct {
+    char magic[4];              // "GRD\0"
+    uint32_t version;
+    uint64_t sourceHash;        // hashFile() of the image the grid was built from
+    int32_t mapWidth, mapHeight;
+    int32_t gridW, gridH;
+    int32_t gridScale;
+    float coastMarginNm;        // setCoastalMargin() the padding was built with
+    int32_t wraps;              // setMapWraps(): padding reaches across the seam
+    uint32_t waterColor;        // setWaterColor() the cells were classified with
+    int32_t waterTolerance;
+} GridFileHeader;
+
+static const void* gridMapping = NULL;
+static size_t gridMappingSize = 0;
+
+uint64_t hashFile(const char* path) {
+    size_t size = 0;
+    const unsigned char* data = (const unsigned char*)mapFile(path, &size);
+    if (!data) return 0;
+    uint64_t h = 14695981039346656037ull;   // FNV-1a, a word at a time
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word; memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ull;
+    }
+    for (; i < size; i++) h = (h ^ data[i]) * 1099511628211ull;
+    h = (h ^ size) * 1099511628211ull;
+    unmapFile(data, size);
+    return h ? h : 1;
+}
+
+int saveCompiledGrid(const char* path, uint64_t sourceHash) {
+    if (!collisionGrid) return 0;
+    GridFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "GRD", 4);
+    header.version = GRID_FILE_VERSION;
+    header.sourceHash = sourceHash;
+    header.mapWidth = mapWidth; header.mapHeight = mapHeight;
+    header.gridW = gridW; header.gridH = gridH;
+    header.gridScale = GRID_SCALE;
+    header.coastMarginNm = coastalMargin();
+    header.wraps = wrapColumns;
+    header.waterColor = waterColor();
+    header.waterTolerance = waterTolerance();
+
+    // Written aside and renamed over, so a worker starting meanwhile never maps half a file.
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return 0;
+    size_t cells = (size_t)gridW * gridH;
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(collisionGrid, 1, cells, f) == cells;
+    if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) remove(path);
+#endif
+    if (!ok || rename(tmp, path) != 0) { remove(tmp); return 0; }
+    return 1;
+}
+
+int loadCompiledGrid(const char* path, uint64_t sourceHash) {
+    PERF_TIMER(t0);
+    size_t size = 0;
+    const void* data = mapFile(path, &size);
+    if (!data) return 0;
+    const GridFileHeader* header = (const GridFileHeader*)data;
+    int ok = size >= sizeof(GridFileHeader) && !memcmp(header->magic, "GRD", 4) &&
+             header->version == GRID_FILE_VERSION && header->gridScale == GRID_SCALE &&
+             header->sourceHash == sourceHash && header->coastMarginNm == coastalMargin() && header->wraps == wrapColumns &&
+             header->waterColor == waterColor() && header->waterTolerance == waterTolerance() && header->gridW > 0 && header->gridH > 0 &&
+             size == sizeof(GridFileHeader) + (size_t)header->gridW * header->gridH;
+    if (!ok) { unmapFile(data, size); return 0; }
+
+    freeCollisionGrid();
+    gridMapping = data; gridMappingSize = size;
+    mapWidth = header->mapWidth; mapHeight = header->mapHeight;
+    gridW = header->gridW; gridH = header->gridH;
+    collisionGrid = (unsigned char*)((const char*)data + sizeof(GridFileHeader));
+    weatherGrid = (float*)calloc(gridW * gridH, sizeof(float));
+    PERF_PHASE(PERF_GRID_LOAD, t0);
+    updateWeatherSimulation();
+    return 1;
+}
+
+int releaseCompiledGrid() {
+    if (!gridMapping) return 0;
+    unmapFile(gridMapping, gridMappingSize);
+    gridMapping = NULL; gridMappingSize = 0;
+    return 1;
+}
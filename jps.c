@@ -0,0 +1,227 @@
+#include "searchctx.h"
+#include <stdlib.h>
+
+// Jump point search over the same movement model as astarSearch(): 8 neighbours,
+// diagonal moves allowed past land corners, cost charged on the cell entered.
+// Symmetry pruning is only valid where every step costs the same, so a cell is jumped
+// over only when it and its whole 3x3 block are plain water (jumpMask). Coastal
+// padding, storms and their neighbours end a jump and are expanded in full, which
+// keeps routes identical in cost to A* with the same heuristic.
+//
+// Straight scans use precomputed distances (JPS+): for every cell and each of the four
+// straight directions, how far the next interesting cell is (forced neighbour or a
+// cell outside the mask), or how far the line runs before land. A straight jump is one
+// lookup and a diagonal jump one lookup pair per step.
+//
+// On a wrapping chart (setMapWraps) the two seam columns are left out of the mask, so
+// no jump runs across the seam; they are expanded in full, one step into the far side.
+
+unsigned char* jumpMask = NULL;
+int16_t* jumpDist = NULL;   // 4 per cell; >0 stop cell at that distance, <0 land after -d-1 cells
+
+enum { DIR_E, DIR_W, DIR_S, DIR_N };
+static const int dirR[4] = { 0, 0, 1, -1 };
+static const int dirC[4] = { 1, -1, 0, 0 };
+
+// c may be one column off either edge.
+static inline int passable(int r, int c) {
+    c = stepColumn(c);
+    return r >= 0 && r < gridH && c >= 0 && collisionGrid[r * gridW + c] != 1;
+}
+
+static inline int blocked(int r, int c) { return !passable(r, c); }
+
+static inline int baseCostCell(int idx) {
+    return costField[idx] == 0;
+}
+
+// Forced neighbour test for a straight move into (r, c) heading (dr, dc).
+static inline int forcedStraight(int r, int c, int dr, int dc) {
+    if (dr == 0)
+        return (blocked(r - 1, c) && passable(r - 1, c + dc)) ||
+               (blocked(r + 1, c) && passable(r + 1, c + dc));
+    return (blocked(r, c - 1) && passable(r + dr, c - 1)) ||
+           (blocked(r, c + 1) && passable(r + dr, c + 1));
+}
+
+// Distance entry for (r, c) heading d, given the entry of the next cell along d.
+static inline int16_t stepDist(int r, int c, int d, int16_t next) {
+    int nr = r + dirR[d], nc = stepColumn(c + dirC[d]);
+    if (blocked(nr, nc)) return -1;
+    int n = nr * gridW + nc;
+    if (!jumpMask[n] || forcedStraight(nr, nc, dirR[d], dirC[d])) return 1;
+    if (next > 0) return next < INT16_MAX ? next + 1 : 1;
+    return next > -INT16_MAX ? next - 1 : 1;
+}
+
+void updateJumpMask() {
+    if (!collisionGrid || !weatherGrid) return;
+    jumpMask = (unsigned char*)realloc(jumpMask, gridW * gridH);
+    jumpDist = (int16_t*)realloc(jumpDist, sizeof(int16_t) * 4 * gridW * gridH);
+    for (int r = 0; r < gridH; r++) {
+        for (int c = 0; c < gridW; c++) {
+            int idx = r * gridW + c;
+            int clean = baseCostCell(idx) && !(wrapColumns && (c == 0 || c == gridW - 1));
+            for (int dr = -1; dr <= 1 && clean; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    int nr = r + dr, nc = c + dc;
+                    if (!passable(nr, nc)) continue;
+                    if (!baseCostCell(nr * gridW + nc)) { clean = 0; break; }
+                }
+            }
+            jumpMask[idx] = (unsigned char)clean;
+        }
+    }
+    // Each sweep runs against its direction so the next cell's entry is already known.
+    for (int r = 0; r < gridH; r++) {
+        for (int c = gridW - 1; c >= 0; c--)
+            jumpDist[(r * gridW + c) * 4 + DIR_E] = stepDist(r, c, DIR_E, c + 1 < gridW ? jumpDist[(r * gridW + c + 1) * 4 + DIR_E] : -1);
+        for (int c = 0; c < gridW; c++)
+            jumpDist[(r * gridW + c) * 4 + DIR_W] = stepDist(r, c, DIR_W, c > 0 ? jumpDist[(r * gridW + c - 1) * 4 + DIR_W] : -1);
+    }
+    for (int c = 0; c < gridW; c++) {
+        for (int r = gridH - 1; r >= 0; r--)
+            jumpDist[(r * gridW + c) * 4 + DIR_S] = stepDist(r, c, DIR_S, r + 1 < gridH ? jumpDist[((r + 1) * gridW + c) * 4 + DIR_S] : -1);
+        for (int r = 0; r < gridH; r++)
+            jumpDist[(r * gridW + c) * 4 + DIR_N] = stepDist(r, c, DIR_N, r > 0 ? jumpDist[((r - 1) * gridW + c) * 4 + DIR_N] : -1);
+    }
+}
+
+// --- Jumps ---
+// Each returns the first jump point in direction (dr, dc) from (r, c), or -1 when the
+// line runs into land. *steps is the number of cells moved.
+static int jumpStraight(int r, int c, int dr, int dc, int goalR, int goalC, int* steps) {
+    int d = dc > 0 ? DIR_E : dc < 0 ? DIR_W : dr > 0 ? DIR_S : DIR_N;
+    int dist = jumpDist[(r * gridW + c) * 4 + d];
+    int reach = dist > 0 ? dist : -dist - 1;
+    int toGoal = dr == 0 ? (goalR == r ? (goalC - c) * dc : -1) : (goalC == c ? (goalR - r) * dr : -1);
+    if (toGoal > 0 && toGoal <= reach) dist = toGoal;
+    else if (dist < 0) return -1;
+    *steps = dist;
+    return (r + dr * dist) * gridW + stepColumn(c + dc * dist);
+}
+
+// Diagonal scans stop where a straight probe finds a forced neighbour or the goal.
+// A probe that only reaches a cell outside the mask does not stop the scan: that cell
+// is handed to relax() directly with the diagonal's origin as parent, and buildPath()
+// rebuilds the bend (diagonal first, then straight).
+typedef struct {
+    SearchContext* ctx;
+    int goalR, goalC, goalIdx;
+} JumpQuery;
+
+static void relax(JumpQuery* q, int from, float g, int idx) {
+    SearchContext* ctx = q->ctx;
+    if (ctx->stamp[idx] != ctx->generation || g < ctx->g[idx]) {
+        ctx->stamp[idx] = ctx->generation;
+        ctx->g[idx] = g;
+        ctx->parent[idx] = from;
+        openPush(&ctx->openList, idx, g + heuristic(ctx, idx / gridW, idx % gridW, q->goalR, q->goalC));
+    }
+}
+
+static int jumpDiagonal(JumpQuery* q, int from, float g, int dr, int dc, int* steps) {
+    int r = from / gridW, c = from % gridW;
+    for (;;) {
+        r += dr; c = stepColumn(c + dc);
+        if (!passable(r, c)) return -1;
+        (*steps)++;
+        int idx = r * gridW + c;
+        if (idx == q->goalIdx || !jumpMask[idx]) return idx;
+        if ((blocked(r, c - dc) && passable(r + dr, c - dc)) ||
+            (blocked(r - dr, c) && passable(r - dr, c + dc))) return idx;
+        g += STEP_DIAGONAL;
+        int probeDir[2][2] = { { 0, dc }, { dr, 0 } };
+        int stop = 0;
+        for (int k = 0; k < 2; k++) {
+            int len = 0;
+            int hit = jumpStraight(r, c, probeDir[k][0], probeDir[k][1], q->goalR, q->goalC, &len);
+            if (hit < 0) continue;
+            if (hit == q->goalIdx || jumpMask[hit]) { stop = 1; continue; }
+            relax(q, from, g + (len - 1) * STEP_STRAIGHT + enterCost(hit, 0), hit);
+        }
+        if (stop) return idx;
+    }
+}
+
+// Directions worth jumping in from (r, c) when it was entered moving (dr, dc).
+static int prunedDirections(int r, int c, int dr, int dc, int dirs[8][2]) {
+    int n = 0;
+    if (dr != 0 && dc != 0) {
+        dirs[n][0] = 0;  dirs[n][1] = dc; n++;
+        dirs[n][0] = dr; dirs[n][1] = 0;  n++;
+        dirs[n][0] = dr; dirs[n][1] = dc; n++;
+        if (blocked(r, c - dc)) { dirs[n][0] = dr;  dirs[n][1] = -dc; n++; }
+        if (blocked(r - dr, c)) { dirs[n][0] = -dr; dirs[n][1] = dc;  n++; }
+    } else if (dr == 0) {
+        dirs[n][0] = 0; dirs[n][1] = dc; n++;
+        if (blocked(r - 1, c)) { dirs[n][0] = -1; dirs[n][1] = dc; n++; }
+        if (blocked(r + 1, c)) { dirs[n][0] = 1;  dirs[n][1] = dc; n++; }
+    } else {
+        dirs[n][0] = dr; dirs[n][1] = 0; n++;
+        if (blocked(r, c - 1)) { dirs[n][0] = dr; dirs[n][1] = -1; n++; }
+        if (blocked(r, c + 1)) { dirs[n][0] = dr; dirs[n][1] = 1;  n++; }
+    }
+    return n;
+}
+
+int jpsSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out) {
+    if (!jumpMask) updateJumpMask();
+    int endR = goal.r, endC = goal.c;
+
+    beginSearch(ctx);
+    OpenList* openList = &ctx->openList;
+    float* gScore = ctx->g;
+    int32_t* parent = ctx->parent;
+    uint32_t* stamp = ctx->stamp;
+    uint32_t gen = ctx->generation;
+
+    int startIdx = start.r * gridW + start.c;
+    int goalIdx = endR * gridW + endC;
+    beginHeuristic(ctx, goalIdx);
+    JumpQuery q = { ctx, endR, endC, goalIdx };
+    stamp[startIdx] = gen;
+    gScore[startIdx] = 0;
+    parent[startIdx] = -1;
+    openPush(openList, startIdx, heuristic(ctx, start.r, start.c, endR, endC));
+
+    static const int allDirections[8][2] = {
+        {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
+    };
+    int found = 0, currIdx;
+    float currF;
+    while ((currIdx = openPop(openList, &currF)) >= 0) {
+        int currR = currIdx / gridW, currC = currIdx % gridW;
+        float currG = gScore[currIdx];
+        if (currF > currG + heuristic(ctx, currR, currC, endR, endC)) continue; // superseded duplicate
+        out->expanded++;
+        if (currIdx == goalIdx) {
+            found = 1;
+            out->cost = currG;
+            buildPath(parent, currIdx, out);
+            break;
+        }
+
+        int dirs[8][2], nd;
+        int p = parent[currIdx];
+        if (p < 0 || !jumpMask[currIdx]) {
+            for (nd = 0; nd < 8; nd++) { dirs[nd][0] = allDirections[nd][0]; dirs[nd][1] = allDirections[nd][1]; }
+        } else {
+            int pr = p / gridW, pc = p % gridW;
+            nd = prunedDirections(currR, currC, (currR > pr) - (currR < pr), (currC > pc) - (currC < pc), dirs);
+        }
+
+        for (int k = 0; k < nd; k++) {
+            int dr = dirs[k][0], dc = dirs[k][1], diagonal = dr != 0 && dc != 0;
+            int steps = 0;
+            int idx = diagonal ? jumpDiagonal(&q, currIdx, currG, dr, dc, &steps)
+                               : jumpStraight(currR, currC, dr, dc, endR, endC, &steps);
+            if (idx < 0) continue;
+
+            // Cells passed over are plain water; only the landing cell can carry a penalty.
+            float tentativeG = currG + (steps - 1) * (diagonal ? STEP_DIAGONAL : STEP_STRAIGHT);
+            relax(&q, currIdx, tentativeG + enterCost(idx, diagonal), idx);
+        }
+    }
+    return found;
+}
@@ -0,0 +1,46 @@
+#include "mapfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+const void* mapFile(const char* path, size_t* size) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(file, &len) || len.QuadPart == 0) { CloseHandle(file); return NULL; }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return NULL;
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);   // the view keeps the mapping alive
+    if (data) *size = (size_t)len.QuadPart;
+    return data;
+}
+
+void unmapFile(const void* data, size_t size) {
+    (void)size;
+    if (data) UnmapViewOfFile(data);
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const void* mapFile(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return NULL; }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);   // the mapping keeps the file open
+    if (data == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return data;
+}
+
+void unmapFile(const void* data, size_t size) {
+    if (data) munmap((void*)data, size);
+}
+#endif
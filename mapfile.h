@@ -0,0 +1,12 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+// Read-only file mappings for the precomputed tables. Pages are shared between
+// processes that map the same file and only faulted in when touched.
+#include <stddef.h>
+
+// Returns NULL if the file is missing or empty; *size receives its length.
+const void* mapFile(const char* path, size_t* size);
+void unmapFile(const void* data, size_t size);
+
+#endif
@@ -0,0 +1,311 @@
+#include "maptiles.h"
+#include "mapfile.h"
+#include <SDL2/SDL_image.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Tile file: a fixed header, the file offset of every tile (level by level, rows top
+// to bottom), then the tiles as ARGB8888 rows. Edge tiles are stored cropped. Level l
+// is the image halved l times (2x2 box filter) and the last level fits in one tile.
+// Textures are all MAP_TILE_SIZE square and recycled between tiles; an edge tile
+// uses its top-left corner. A frame uploads at most UPLOADS_PER_FRAME tiles, so
+// zooming or panning into new ground never stalls on a burst of uploads.
+
+#define TILE_FILE_VERSION 1
+#define TILE_LEVELS_MAX 16
+#define TILE_CACHE_SLOTS 96
+#define UPLOADS_PER_FRAME 6
+
+typedef struct {
+    char magic[4];              // "TIL\0"
+    uint32_t version;
+    uint64_t sourceHash;        // hashFile() of the image
+    int32_t width, height;
+    int32_t tileSize;
+    int32_t levels;
+} TileFileHeader;
+
+typedef struct {
+    int level, tx, ty;          // level -1: free
+    SDL_Texture* tex;
+    unsigned lastUsed;
+} TileSlot;
+
+struct MapTiles {
+    SDL_Renderer* ren;
+    char imagePath[1024], tilePath[1024];
+    uint64_t sourceHash;
+    SDL_Thread* builder;
+    SDL_atomic_t state;         // see mapTilesReady()
+    SDL_atomic_t cancel;
+
+    // Layout, valid once state is 1.
+    const unsigned char* data;
+    size_t size;
+    const uint64_t* offsets;
+    int width, height, levels;
+    int levelW[TILE_LEVELS_MAX], levelH[TILE_LEVELS_MAX];
+    int tilesX[TILE_LEVELS_MAX], tilesY[TILE_LEVELS_MAX], firstTile[TILE_LEVELS_MAX + 1];
+
+    TileSlot slots[TILE_CACHE_SLOTS];
+    unsigned frame;
+    int uploadsLeft;
+};
+
+static void setLayout(MapTiles* mt, int w, int h) {
+    mt->width = w; mt->height = h;
+    mt->levels = 0;
+    mt->firstTile[0] = 0;
+    for (int l = 0; l < TILE_LEVELS_MAX; l++) {
+        mt->levelW[l] = (w + (1 << l) - 1) >> l;
+        mt->levelH[l] = (h + (1 << l) - 1) >> l;
+        mt->tilesX[l] = (mt->levelW[l] + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+        mt->tilesY[l] = (mt->levelH[l] + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+        mt->firstTile[l + 1] = mt->firstTile[l] + mt->tilesX[l] * mt->tilesY[l];
+        mt->levels = l + 1;
+        if (mt->tilesX[l] == 1 && mt->tilesY[l] == 1) break;
+    }
+}
+
+static int tileIndex(const MapTiles* mt, int level, int tx, int ty) {
+    return mt->firstTile[level] + ty * mt->tilesX[level] + tx;
+}
+
+// Size of a tile in texels of its level.
+static void tileSize(const MapTiles* mt, int level, int tx, int ty, int* w, int* h) {
+    int right = (tx + 1) * MAP_TILE_SIZE, bottom = (ty + 1) * MAP_TILE_SIZE;
+    *w = (right < mt->levelW[level] ? right : mt->levelW[level]) - tx * MAP_TILE_SIZE;
+    *h = (bottom < mt->levelH[level] ? bottom : mt->levelH[level]) - ty * MAP_TILE_SIZE;
+}
+
+static int mapTileFile(MapTiles* mt) {
+    size_t size = 0;
+    const unsigned char* data = (const unsigned char*)mapFile(mt->tilePath, &size);
+    if (!data) return 0;
+    const TileFileHeader* header = (const TileFileHeader*)data;
+    int ok = size >= sizeof(TileFileHeader) && !memcmp(header->magic, "TIL", 4) &&
+             header->version == TILE_FILE_VERSION && header->sourceHash == mt->sourceHash &&
+             header->tileSize == MAP_TILE_SIZE && header->width > 0 && header->height > 0;
+    if (ok) {
+        setLayout(mt, header->width, header->height);
+        int tiles = mt->firstTile[mt->levels];
+        size_t table = sizeof(TileFileHeader) + sizeof(uint64_t) * tiles;
+        ok = header->levels == mt->levels && size >= table;
+        if (ok) {
+            const uint64_t* offsets = (const uint64_t*)(data + sizeof(TileFileHeader));
+            int w, h;
+            tileSize(mt, mt->levels - 1, 0, 0, &w, &h);
+            ok = offsets[0] == table && offsets[tiles - 1] + (uint64_t)w * h * 4 == size;
+            mt->offsets = offsets;
+        }
+    }
+    if (!ok) { unmapFile(data, size); return 0; }
+    mt->data = data;
+    mt->size = size;
+    return 1;
+}
+
+// Averages 2x2 blocks (the last row or column pairs with itself on odd sizes).
+static uint32_t* halve(const uint32_t* src, int pitch, int w, int h) {
+    int nw = (w + 1) / 2, nh = (h + 1) / 2;
+    uint32_t* out = (uint32_t*)malloc(sizeof(uint32_t) * nw * nh);
+    if (!out) return NULL;
+    for (int y = 0; y < nh; y++) {
+        const uint32_t* row0 = src + (size_t)(2 * y) * pitch;
+        const uint32_t* row1 = src + (size_t)(2 * y + 1 < h ? 2 * y + 1 : 2 * y) * pitch;
+        for (int x = 0; x < nw; x++) {
+            int x0 = 2 * x, x1 = 2 * x + 1 < w ? 2 * x + 1 : 2 * x;
+            uint32_t a = row0[x0], b = row0[x1], c = row1[x0], d = row1[x1];
+            // Two channels per word, ten bits of headroom each.
+            uint32_t lo = (a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) + (d & 0x00FF00FF) + 0x00020002;
+            uint32_t hi = ((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) + ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF) + 0x00020002;
+            out[(size_t)y * nw + x] = ((lo >> 2) & 0x00FF00FF) | (((hi >> 2) & 0x00FF00FF) << 8);
+        }
+    }
+    return out;
+}
+
+static int writeTiles(MapTiles* mt, const SDL_Surface* surf) {
+    setLayout(mt, surf->w, surf->h);
+    int tiles = mt->firstTile[mt->levels];
+    uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * tiles);
+    if (!offsets) return 0;
+    uint64_t at = sizeof(TileFileHeader) + sizeof(uint64_t) * tiles;
+    for (int l = 0; l < mt->levels; l++)
+        for (int ty = 0; ty < mt->tilesY[l]; ty++)
+            for (int tx = 0; tx < mt->tilesX[l]; tx++) {
+                int w, h;
+                tileSize(mt, l, tx, ty, &w, &h);
+                offsets[tileIndex(mt, l, tx, ty)] = at;
+                at += (uint64_t)w * h * 4;
+            }
+    TileFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TIL", 4);
+    header.version = TILE_FILE_VERSION;
+    header.sourceHash = mt->sourceHash;
+    header.width = surf->w; header.height = surf->h;
+    header.tileSize = MAP_TILE_SIZE;
+    header.levels = mt->levels;
+
+    // Written aside and renamed over, like the compiled grid.
+    char tmp[1040];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", mt->tilePath);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) { free(offsets); return 0; }
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(offsets, sizeof(uint64_t), tiles, f) == (size_t)tiles;
+    free(offsets);
+
+    const uint32_t* pixels = (const uint32_t*)surf->pixels;
+    int pitch = surf->pitch / 4;
+    uint32_t* owned = NULL;     // levels past the first
+    for (int l = 0; ok && l < mt->levels; l++) {
+        for (int ty = 0; ok && ty < mt->tilesY[l]; ty++)
+            for (int tx = 0; ok && tx < mt->tilesX[l]; tx++) {
+                int w, h;
+                tileSize(mt, l, tx, ty, &w, &h);
+                const uint32_t* corner = pixels + (size_t)ty * MAP_TILE_SIZE * pitch + tx * MAP_TILE_SIZE;
+                for (int r = 0; ok && r < h; r++) ok = fwrite(corner + (size_t)r * pitch, 4, w, f) == (size_t)w;
+                if (SDL_AtomicGet(&mt->cancel)) ok = 0;
+            }
+        if (!ok || l + 1 == mt->levels) break;
+        uint32_t* next = halve(pixels, pitch, mt->levelW[l], mt->levelH[l]);
+        free(owned);
+        owned = next;
+        pixels = next;
+        pitch = mt->levelW[l + 1];
+        if (!next) ok = 0;
+    }
+    free(owned);
+    if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) remove(mt->tilePath);
+#endif
+    if (!ok || rename(tmp, mt->tilePath) != 0) { remove(tmp); return 0; }
+    return 1;
+}
+
+static int buildTiles(void* arg) {
+    MapTiles* mt = (MapTiles*)arg;
+    SDL_Surface* loaded = IMG_Load(mt->imagePath);
+    SDL_Surface* surf = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0) : NULL;
+    if (loaded) SDL_FreeSurface(loaded);
+    int ok = surf && writeTiles(mt, surf) && mapTileFile(mt);
+    if (surf) SDL_FreeSurface(surf);
+    SDL_AtomicSet(&mt->state, ok ? 1 : -1);
+    return ok;
+}
+
+MapTiles* mapTilesOpen(SDL_Renderer* ren, const char* imagePath, const char* tilePath, uint64_t sourceHash) {
+    MapTiles* mt = (MapTiles*)calloc(1, sizeof(MapTiles));
+    if (!mt) return NULL;
+    mt->ren = ren;
+    snprintf(mt->imagePath, sizeof(mt->imagePath), "%s", imagePath);
+    snprintf(mt->tilePath, sizeof(mt->tilePath), "%s", tilePath);
+    mt->sourceHash = sourceHash;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) mt->slots[i].level = -1;
+    mt->uploadsLeft = UPLOADS_PER_FRAME;
+    if (sourceHash && mapTileFile(mt)) SDL_AtomicSet(&mt->state, 1);
+    else if (!(mt->builder = SDL_CreateThread(buildTiles, "maptiles", mt))) SDL_AtomicSet(&mt->state, -1);
+    return mt;
+}
+
+void mapTilesFree(MapTiles* mt) {
+    if (!mt) return;
+    if (mt->builder) {
+        SDL_AtomicSet(&mt->cancel, 1);
+        SDL_WaitThread(mt->builder, NULL);
+    }
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) if (mt->slots[i].tex) SDL_DestroyTexture(mt->slots[i].tex);
+    if (mt->data) unmapFile(mt->data, mt->size);
+    free(mt);
+}
+
+int mapTilesReady(MapTiles* mt) { return mt ? SDL_AtomicGet(&mt->state) : -1; }
+
+// The cached texture of a tile, uploading it if the frame's budget allows and a slot
+// not drawn this frame is free to take.
+static SDL_Texture* tileTexture(MapTiles* mt, int level, int tx, int ty, int upload) {
+    TileSlot* victim = NULL;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        TileSlot* s = &mt->slots[i];
+        if (s->level == level && s->tx == tx && s->ty == ty) { s->lastUsed = mt->frame; return s->tex; }
+        if (s->lastUsed == mt->frame && s->level >= 0) continue;
+        if (!victim || s->level < 0 || (victim->level >= 0 && s->lastUsed < victim->lastUsed)) victim = s;
+    }
+    if (!upload || mt->uploadsLeft <= 0 || !victim) return NULL;
+    if (!victim->tex) {
+        victim->tex = SDL_CreateTexture(mt->ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, MAP_TILE_SIZE, MAP_TILE_SIZE);
+        if (!victim->tex) return NULL;
+        SDL_SetTextureBlendMode(victim->tex, SDL_BLENDMODE_BLEND);
+    }
+    int w, h;
+    tileSize(mt, level, tx, ty, &w, &h);
+    SDL_Rect area = { 0, 0, w, h };
+    const void* pixels = mt->data + mt->offsets[tileIndex(mt, level, tx, ty)];
+    victim->level = -1;
+    if (SDL_UpdateTexture(victim->tex, &area, pixels, w * 4) != 0) return NULL;
+    victim->level = level; victim->tx = tx; victim->ty = ty;
+    victim->lastUsed = mt->frame;
+    mt->uploadsLeft--;
+    return victim->tex;
+}
+
+static void drawTile(MapTiles* mt, int level, int tx, int ty, float x, float y, float zoom) {
+    int w, h;
+    tileSize(mt, level, tx, ty, &w, &h);
+    // The tile's extent in image pixels, and on screen.
+    int px0 = (tx * MAP_TILE_SIZE) << level, py0 = (ty * MAP_TILE_SIZE) << level;
+    int px1 = (tx * MAP_TILE_SIZE + w) << level, py1 = (ty * MAP_TILE_SIZE + h) << level;
+    if (px1 > mt->width) px1 = mt->width;
+    if (py1 > mt->height) py1 = mt->height;
+    int left = (int)floorf(x + px0 * zoom), top = (int)floorf(y + py0 * zoom);
+    SDL_Rect dst = { left, top, (int)floorf(x + px1 * zoom) - left, (int)floorf(y + py1 * zoom) - top };
+    if (dst.w <= 0 || dst.h <= 0) return;
+
+    SDL_Texture* tex = tileTexture(mt, level, tx, ty, 1);
+    if (tex) {
+        SDL_Rect src = { 0, 0, w, h };
+        SDL_RenderCopy(mt->ren, tex, &src, &dst);
+        return;
+    }
+    // Stand-in: the same ground cut from a coarser tile already uploaded.
+    for (int l = level + 1; l < mt->levels; l++) {
+        int cx0 = px0 >> l, cy0 = py0 >> l;
+        int ctx = cx0 / MAP_TILE_SIZE, cty = cy0 / MAP_TILE_SIZE;
+        tex = tileTexture(mt, l, ctx, cty, 0);
+        if (!tex) continue;
+        int cx1 = (px1 + (1 << l) - 1) >> l, cy1 = (py1 + (1 << l) - 1) >> l;
+        SDL_Rect src = { cx0 - ctx * MAP_TILE_SIZE, cy0 - cty * MAP_TILE_SIZE, cx1 - cx0, cy1 - cy0 };
+        SDL_RenderCopy(mt->ren, tex, &src, &dst);
+        return;
+    }
+}
+
+void mapTilesDraw(MapTiles* mt, float x, float y, float zoom) {
+    if (!mt || zoom <= 0 || SDL_AtomicGet(&mt->state) != 1) return;
+    int screenW, screenH;
+    if (SDL_GetRendererOutputSize(mt->ren, &screenW, &screenH) != 0) return;
+    if (x >= screenW || y >= screenH || x + mt->width * zoom <= 0 || y + mt->height * zoom <= 0) return;
+
+    // The coarsest level that still has a texel for every screen pixel.
+    int level = 0;
+    while (level + 1 < mt->levels && zoom * (float)(1 << (level + 1)) <= 1.0f) level++;
+    float span = MAP_TILE_SIZE * zoom * (float)(1 << level);
+    int tx0 = (int)floorf(-x / span), tx1 = (int)floorf((screenW - x) / span);
+    int ty0 = (int)floorf(-y / span), ty1 = (int)floorf((screenH - y) / span);
+    if (tx0 < 0) tx0 = 0;
+    if (ty0 < 0) ty0 = 0;
+    if (tx1 >= mt->tilesX[level]) tx1 = mt->tilesX[level] - 1;
+    if (ty1 >= mt->tilesY[level]) ty1 = mt->tilesY[level] - 1;
+    for (int ty = ty0; ty <= ty1; ty++)
+        for (int tx = tx0; tx <= tx1; tx++) drawTile(mt, level, tx, ty, x, y, zoom);
+}
+
+void mapTilesEndFrame(MapTiles* mt) {
+    if (!mt) return;
+    mt->frame++;
+    mt->uploadsLeft = UPLOADS_PER_FRAME;
+}
@@ -0,0 +1,29 @@
+#ifndef MAPTILES_H
+#define MAPTILES_H
+
+// The chart for the viewer (storm2.c) as a tile pyramid: the image and its halvings,
+// each cut into MAP_TILE_SIZE tiles, compiled next to the chart (assets/temp1.tiles)
+// and mapped like the collision grid. A frame uploads and draws only the tiles on
+// screen at the level matching the zoom; their textures live in a small LRU cache,
+// so charts larger than the GPU's texture limit draw as well as small ones.
+// Without an up-to-date tile file the image is decoded and the file written on a
+// background thread; until then nothing is drawn.
+#include <SDL2/SDL.h>
+#include <stdint.h>
+
+#define MAP_TILE_SIZE 512
+
+typedef struct MapTiles MapTiles;
+
+// sourceHash: hashFile() of imagePath, which keys the tile file.
+MapTiles* mapTilesOpen(SDL_Renderer* ren, const char* imagePath, const char* tilePath, uint64_t sourceHash);
+void mapTilesFree(MapTiles* mt);
+// 1 once the pyramid can be drawn, -1 if building it failed, 0 while it is built.
+int mapTilesReady(MapTiles* mt);
+// Draws the chart with its top-left corner at screen x, y, zoom screen pixels per
+// image pixel. A tile not uploaded yet is drawn from the nearest coarser one that is.
+void mapTilesDraw(MapTiles* mt, float x, float y, float zoom);
+// Call once per frame, after drawing: renews the upload budget and ages the cache.
+void mapTilesEndFrame(MapTiles* mt);
+
+#endif
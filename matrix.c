@@ -0,0 +1,137 @@
+#include "searchctx.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// Port-to-port matrix: one Dijkstra per source instead of one A* per pair. Every port
+// cell is marked in a shared table; a source's search settles cells in cost order and
+// stops as soon as the last port cell is settled, so each row costs about one search
+// to the farthest port. Costs are the ones an optimal (octile) astarSearch() returns.
+// Sources are handed out one at a time from an atomic counter to parallelRun workers,
+// each with its own SearchContext.
+
+typedef struct {
+    const GridPos* ports;
+    int count;
+    int* portAt;            // per cell: first port on it, -1 if none
+    int* nextPort;          // further ports on the same cell
+    int portCells;          // distinct cells holding a port
+    float* costs;
+    float* hours;
+    RoutePath* paths;
+    atomic_int nextSource;
+    atomic_int reached;     // pairs
+} MatrixJob;
+
+static void matrixRow(MatrixJob* job, SearchContext* ctx, int src) {
+    int count = job->count;
+    float* costRow = job->costs ? job->costs + (size_t)src * count : NULL;
+    float* hourRow = job->hours ? job->hours + (size_t)src * count : NULL;
+    RoutePath* pathRow = job->paths ? job->paths + (size_t)src * count : NULL;
+    for (int j = 0; j < count; j++) {
+        if (costRow) costRow[j] = INFINITY;
+        if (hourRow) hourRow[j] = INFINITY;
+        if (pathRow) { pathRow[j].cells = NULL; pathRow[j].len = 0; pathRow[j].cost = 0; pathRow[j].expanded = 0; pathRow[j].hours = 0; }
+    }
+    GridPos s = job->ports[src];
+    if (s.r < 0 || s.r >= gridH || s.c < 0 || s.c >= gridW || costField[s.r * gridW + s.c] == COST_LAND) return;
+
+    PERF_TIMER(t0);
+    beginSearch(ctx);
+    if (!ctx->arrival) ctx->arrival = (float*)malloc(ctx->cells * sizeof(float));
+    OpenList* openList = &ctx->openList;
+    PERF_ONLY(openList->pushes = openList->pops = 0; openList->peak = 0;)
+    float* gScore = ctx->g;
+    float* sailed = ctx->arrival;   // distance in cells along the best path
+    int32_t* parent = ctx->parent;
+    uint32_t* stamp = ctx->stamp;
+    uint32_t gen = ctx->generation;
+    float hoursPerCell = serviceSpeed() > 0 ? nmPerCell() / serviceSpeed() : 0;
+
+    int startIdx = s.r * gridW + s.c;
+    stamp[startIdx] = gen;
+    gScore[startIdx] = 0;
+    sailed[startIdx] = 0;
+    parent[startIdx] = -1;
+    openPush(openList, startIdx, 0);
+
+    int remaining = job->portCells, expanded = 0, currIdx;
+    float currF;
+    while (remaining > 0 && (currIdx = openPop(openList, &currF)) >= 0) {
+        float currG = gScore[currIdx];
+        if (currF > currG) continue; // superseded duplicate
+        expanded++;
+        if (job->portAt[currIdx] >= 0) {
+            for (int j = job->portAt[currIdx]; j >= 0; j = job->nextPort[j]) {
+                atomic_fetch_add(&job->reached, 1);
+                if (costRow) costRow[j] = currG;
+                if (hourRow) hourRow[j] = sailed[currIdx] * hoursPerCell;
+                if (pathRow) {
+                    buildPath(parent, currIdx, &pathRow[j]);
+                    pathRow[j].cost = currG;
+                    pathRow[j].hours = sailed[currIdx] * hoursPerCell;
+                    pathRow[j].expanded = expanded;
+                }
+            }
+            remaining--;
+        }
+
+        int currR = currIdx / gridW, currC = currIdx % gridW;
+        for (int k = 0; k < 8; k++) {
+            int nr = currR + neighbourDr[k], nc = stepColumn(currC + neighbourDc[k]);
+            if (nr < 0 || nr >= gridH || nc < 0) continue;
+            int idx = nr * gridW + nc;
+            uint16_t penalty = costField[idx];
+            if (penalty == COST_LAND) continue;
+
+            float tentativeG = currG + (neighbourStep[k] + penalty * (1.0f / COST_SCALE));
+            if (stamp[idx] != gen || tentativeG < gScore[idx]) {
+                stamp[idx] = gen;
+                gScore[idx] = tentativeG;
+                sailed[idx] = sailed[currIdx] + neighbourStep[k];
+                parent[idx] = currIdx;
+                openPush(openList, idx, tentativeG);
+            }
+        }
+    }
+    PERF_SEARCH(expanded, openList->pushes, openList->pops, openList->peak, t0);
+}
+
+static void matrixWorker(void* arg, int worker) {
+    (void)worker;   // sources are claimed from the counter, not assigned per worker
+    MatrixJob* job = (MatrixJob*)arg;
+    SearchContext* ctx = searchContextCreate();
+    for (int src; (src = atomic_fetch_add(&job->nextSource, 1)) < job->count; ) matrixRow(job, ctx, src);
+    searchContextFree(ctx);
+}
+
+int distanceMatrix(const GridPos* ports, int count, float* costs, float* hours, RoutePath* paths) {
+    if (!collisionGrid || !costField || count <= 0) return 0;
+    MatrixJob job;
+    job.ports = ports;
+    job.count = count;
+    job.costs = costs; job.hours = hours; job.paths = paths;
+    job.portCells = 0;
+    atomic_init(&job.nextSource, 0);
+    atomic_init(&job.reached, 0);
+    int cells = gridW * gridH;
+    job.portAt = (int*)malloc(sizeof(int) * cells);
+    job.nextPort = (int*)malloc(sizeof(int) * count);
+    if (!job.portAt || !job.nextPort) { free(job.portAt); free(job.nextPort); return 0; }
+    for (int i = 0; i < cells; i++) job.portAt[i] = -1;
+    for (int j = count - 1; j >= 0; j--) {
+        job.nextPort[j] = -1;
+        GridPos p = ports[j];
+        if (p.r < 0 || p.r >= gridH || p.c < 0 || p.c >= gridW || costField[p.r * gridW + p.c] == COST_LAND) continue;
+        int idx = p.r * gridW + p.c;
+        if (job.portAt[idx] < 0) job.portCells++;
+        job.nextPort[j] = job.portAt[idx];
+        job.portAt[idx] = j;
+    }
+
+    int workers = parallelWorkers();
+    parallelRun(workers < count ? workers : count, matrixWorker, &job);
+    free(job.portAt);
+    free(job.nextPort);
+    return atomic_load(&job.reached);
+}
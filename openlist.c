@@ -0,0 +1,180 @@
+#include "openlist.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void growHeap(OpenList* ol) {
+    if (ol->size < ol->capacity) return;
+    ol->capacity = ol->capacity ? ol->capacity * 2 : 1024;
+    ol->heap = realloc(ol->heap, sizeof(OpenEntry) * ol->capacity);
+}
+
+// --- Binary Heap (duplicates, no decrease-key) ---
+static void binaryPush(OpenList* ol, OpenEntry e) {
+    growHeap(ol);
+    int i = ol->size++;
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (ol->heap[p].f <= e.f) break;
+        ol->heap[i] = ol->heap[p];
+        i = p;
+    }
+    ol->heap[i] = e;
+}
+
+static OpenEntry binaryPop(OpenList* ol) {
+    OpenEntry res = ol->heap[0];
+    OpenEntry last = ol->heap[--ol->size];
+    int i = 0;
+    while (i * 2 + 1 < ol->size) {
+        int child = i * 2 + 1;
+        if (child + 1 < ol->size && ol->heap[child + 1].f < ol->heap[child].f) child++;
+        if (last.f <= ol->heap[child].f) break;
+        ol->heap[i] = ol->heap[child];
+        i = child;
+    }
+    ol->heap[i] = last;
+    return res;
+}
+
+// --- Indexed 4-ary Heap (decrease-key) ---
+static void quadPlace(OpenList* ol, int i, OpenEntry e) {
+    ol->heap[i] = e;
+    ol->heapPos[e.idx] = i;
+}
+
+static void quadSiftUp(OpenList* ol, int i, OpenEntry e) {
+    while (i > 0) {
+        int p = (i - 1) / 4;
+        if (ol->heap[p].f <= e.f) break;
+        quadPlace(ol, i, ol->heap[p]);
+        i = p;
+    }
+    quadPlace(ol, i, e);
+}
+
+static void quadSiftDown(OpenList* ol, int i, OpenEntry e) {
+    for (;;) {
+        int first = i * 4 + 1;
+        if (first >= ol->size) break;
+        int end = first + 4 < ol->size ? first + 4 : ol->size;
+        int best = first;
+        for (int c = first + 1; c < end; c++)
+            if (ol->heap[c].f < ol->heap[best].f) best = c;
+        if (e.f <= ol->heap[best].f) break;
+        quadPlace(ol, i, ol->heap[best]);
+        i = best;
+    }
+    quadPlace(ol, i, e);
+}
+
+static void quadPush(OpenList* ol, OpenEntry e) {
+    int slot = ol->heapPos[e.idx];
+    if (slot >= 0) {
+        if (e.f < ol->heap[slot].f) quadSiftUp(ol, slot, e);
+        else quadSiftDown(ol, slot, e);
+        return;
+    }
+    growHeap(ol);
+    quadSiftUp(ol, ol->size++, e);
+}
+
+static OpenEntry quadPop(OpenList* ol) {
+    OpenEntry res = ol->heap[0];
+    ol->heapPos[res.idx] = -1;
+    OpenEntry last = ol->heap[--ol->size];
+    if (ol->size > 0) quadSiftDown(ol, 0, last);
+    return res;
+}
+
+// --- Monotone Radix Heap ---
+// Keys are f in fixed point. The weighted heuristic is not consistent, so a child can
+// come out a fraction of a step below the last popped key. Those go to a small binary
+// heap that is drained first; everything in it is below every bucketed key, so the
+// pop order stays exact up to the fixed-point quantum.
+static int radixBucketOf(uint32_t key, uint32_t last) {
+    return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+}
+
+static void radixAppend(RadixBucket* b, RadixEntry e) {
+    if (b->size == b->capacity) {
+        b->capacity = b->capacity ? b->capacity * 2 : 256;
+        b->items = realloc(b->items, sizeof(RadixEntry) * b->capacity);
+    }
+    b->items[b->size++] = e;
+}
+
+static void radixPush(OpenList* ol, int idx, float f) {
+    float scaled = f * RADIX_SCALE;
+    uint32_t key = scaled >= 4294967040.0f ? 0xFFFFFF00u : (uint32_t)scaled;
+    if (key < ol->last) { binaryPush(ol, (OpenEntry){f, idx}); return; }
+    radixAppend(&ol->buckets[radixBucketOf(key, ol->last)], (RadixEntry){key, f, idx});
+    ol->radixCount++;
+}
+
+static RadixEntry radixPop(OpenList* ol) {
+    if (ol->size > 0) {
+        OpenEntry e = binaryPop(ol);
+        return (RadixEntry){ol->last, e.f, e.idx};
+    }
+    if (ol->buckets[0].size == 0) {
+        int b = 1;
+        while (ol->buckets[b].size == 0) b++;
+        RadixBucket* src = &ol->buckets[b];
+        uint32_t minKey = src->items[0].key;
+        for (int i = 1; i < src->size; i++)
+            if (src->items[i].key < minKey) minKey = src->items[i].key;
+        ol->last = minKey;
+        // Every entry lands in a strictly lower bucket, so src is never appended to here.
+        for (int i = 0; i < src->size; i++)
+            radixAppend(&ol->buckets[radixBucketOf(src->items[i].key, minKey)], src->items[i]);
+        src->size = 0;
+    }
+    ol->radixCount--;
+    return ol->buckets[0].items[--ol->buckets[0].size];
+}
+
+// --- Dispatch ---
+void openListInit(OpenList* ol, OpenListKind kind, int cells) {
+    memset(ol, 0, sizeof(*ol));
+    ol->kind = kind;
+    ol->cells = cells;
+    if (kind == OPEN_QUAD_HEAP) {
+        ol->heapPos = (int*)malloc(cells * sizeof(int));
+        memset(ol->heapPos, 0xFF, cells * sizeof(int));
+    }
+}
+
+void openListFree(OpenList* ol) {
+    free(ol->heap); free(ol->heapPos);
+    for (int b = 0; b < RADIX_BUCKETS; b++) free(ol->buckets[b].items);
+    memset(ol, 0, sizeof(*ol));
+}
+
+// Cost is proportional to what is still queued, not to the grid.
+void openListClear(OpenList* ol) {
+    if (ol->heapPos)
+        for (int i = 0; i < ol->size; i++) ol->heapPos[ol->heap[i].idx] = -1;
+    for (int b = 0; b < RADIX_BUCKETS; b++) ol->buckets[b].size = 0;
+    ol->size = 0;
+    ol->radixCount = 0;
+    ol->last = 0;
+}
+
+void openPush(OpenList* ol, int idx, float f) {
+    switch (ol->kind) {
+        case OPEN_QUAD_HEAP: quadPush(ol, (OpenEntry){f, idx}); break;
+        case OPEN_RADIX_HEAP: radixPush(ol, idx, f); break;
+        default: binaryPush(ol, (OpenEntry){f, idx}); break;
+    }
+    PERF_ONLY(ol->pushes++; if (ol->size + ol->radixCount > ol->peak) ol->peak = ol->size + ol->radixCount;)
+}
+
+int openPop(OpenList* ol, float* f) {
+    if (ol->size + ol->radixCount == 0) return -1;
+    PERF_ONLY(ol->pops++;)
+    switch (ol->kind) {
+        case OPEN_QUAD_HEAP: { OpenEntry e = quadPop(ol); *f = e.f; return e.idx; }
+        case OPEN_RADIX_HEAP: { RadixEntry e = radixPop(ol); *f = e.f; return e.idx; }
+        default: { OpenEntry e = binaryPop(ol); *f = e.f; return e.idx; }
+    }
+}
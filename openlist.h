@@ -0,0 +1,41 @@
+#ifndef OPENLIST_H
+#define OPENLIST_H
+
+// Open-list backends for the grid searches in route.c. Entries are (f, cell index)
+// pairs stored inline so sift steps never touch the per-cell search state.
+#include "route.h"
+#include "perf.h"
+
+#define RADIX_BUCKETS 33
+#define RADIX_SCALE 256.0f   // f quantized to 1/256 of a straight step
+
+typedef struct { float f; int idx; } OpenEntry;
+typedef struct { uint32_t key; float f; int idx; } RadixEntry;
+typedef struct { RadixEntry* items; int size, capacity; } RadixBucket;
+
+typedef struct {
+    OpenListKind kind;
+    int cells;
+    // binary / quad heap (also the radix heap's below-last overflow)
+    OpenEntry* heap;
+    int size, capacity;
+    int* heapPos;            // quad heap only: slot of each cell, -1 when not queued
+    // radix heap
+    RadixBucket buckets[RADIX_BUCKETS];
+    int radixCount;
+    uint32_t last;           // last popped bucket key
+    // Traffic since the owner last zeroed these (openListClear() keeps them), for perf.h.
+    long long pushes, pops;
+    int peak;                // most entries queued at once
+} OpenList;
+
+void openListInit(OpenList* ol, OpenListKind kind, int cells);
+void openListFree(OpenList* ol);
+void openListClear(OpenList* ol);
+// Quad heap: lowers the key if idx is already queued. Others: queues a duplicate.
+void openPush(OpenList* ol, int idx, float f);
+// Returns -1 when empty. *f is the key idx was pushed with, so callers can drop
+// stale duplicates by comparing it with the cell's current f.
+int openPop(OpenList* ol, float* f);
+
+#endif
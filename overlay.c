@@ -0,0 +1,138 @@
+#include "overlay.h"
+#include "route.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The ramp is flattened into a table of ARGB words by whole knots, so baking is a
+// table lookup per cell. The bake also records the bounding box of the cells it
+// coloured; drawing copies only that box, and only the part of it on screen.
+
+#define RAMP_MAX_STOPS 16
+#define RAMP_KTS 256
+
+struct WeatherOverlay {
+    SDL_Renderer* ren;
+    SDL_Texture* tex;
+    int texW, texH;
+    unsigned revision;      // weatherRevision() of the bake
+    int baked;              // texture holds the ramp's colours for that revision
+    SDL_Rect extent;        // cells with any colour, empty if calm everywhere
+    WindColor stops[RAMP_MAX_STOPS];
+    int stopCount;
+    Uint32 ramp[RAMP_KTS];
+};
+
+static const WindColor defaultRamp[] = {
+    { 20.0f, { 255, 230,   0,   0 } },
+    { STORM_THRESHOLD, { 255, 170,   0,  50 } },
+    { 48.0f, { 255,  60,   0,  80 } },
+    { 64.0f, { 220,   0,   0, 110 } },
+    { 90.0f, { 160,   0, 200, 140 } },
+};
+
+static void buildRamp(WeatherOverlay* o) {
+    for (int k = 0; k < RAMP_KTS; k++) {
+        int s = 0;
+        while (s < o->stopCount && o->stops[s].kts <= k) s++;
+        SDL_Color c;
+        if (s == 0) { o->ramp[k] = 0; continue; }
+        if (s == o->stopCount) c = o->stops[s - 1].color;
+        else {
+            const WindColor* a = &o->stops[s - 1];
+            const WindColor* b = &o->stops[s];
+            float t = (k - a->kts) / (b->kts - a->kts);
+            c.r = (Uint8)(a->color.r + (b->color.r - a->color.r) * t + 0.5f);
+            c.g = (Uint8)(a->color.g + (b->color.g - a->color.g) * t + 0.5f);
+            c.b = (Uint8)(a->color.b + (b->color.b - a->color.b) * t + 0.5f);
+            c.a = (Uint8)(a->color.a + (b->color.a - a->color.a) * t + 0.5f);
+        }
+        o->ramp[k] = c.a ? (Uint32)c.a << 24 | (Uint32)c.r << 16 | (Uint32)c.g << 8 | c.b : 0;
+    }
+    o->baked = 0;
+}
+
+WeatherOverlay* weatherOverlayCreate(SDL_Renderer* ren) {
+    WeatherOverlay* o = (WeatherOverlay*)calloc(1, sizeof(WeatherOverlay));
+    if (!o) return NULL;
+    o->ren = ren;
+    weatherOverlaySetRamp(o, defaultRamp, (int)(sizeof(defaultRamp) / sizeof(defaultRamp[0])));
+    return o;
+}
+
+void weatherOverlayFree(WeatherOverlay* o) {
+    if (!o) return;
+    if (o->tex) SDL_DestroyTexture(o->tex);
+    free(o);
+}
+
+void weatherOverlaySetRamp(WeatherOverlay* o, const WindColor* stops, int count) {
+    if (count > RAMP_MAX_STOPS) count = RAMP_MAX_STOPS;
+    if (count < 0) count = 0;
+    memcpy(o->stops, stops, sizeof(WindColor) * count);
+    o->stopCount = count;
+    buildRamp(o);
+}
+
+static int bake(WeatherOverlay* o) {
+    if (!weatherGrid || gridW <= 0 || gridH <= 0) return 0;
+    if (!o->tex || o->texW != gridW || o->texH != gridH) {
+        if (o->tex) SDL_DestroyTexture(o->tex);
+        o->tex = SDL_CreateTexture(o->ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, gridW, gridH);
+        if (!o->tex) return 0;
+        SDL_SetTextureBlendMode(o->tex, SDL_BLENDMODE_BLEND);
+        o->texW = gridW; o->texH = gridH;
+    }
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(o->tex, NULL, &pixels, &pitch) != 0) return 0;
+    int minR = gridH, maxR = -1, minC = gridW, maxC = -1;
+    for (int r = 0; r < gridH; r++) {
+        Uint32* row = (Uint32*)((Uint8*)pixels + (size_t)r * pitch);
+        const float* wind = weatherGrid + (size_t)r * gridW;
+        int rowMin = gridW, rowMax = -1;
+        for (int c = 0; c < gridW; c++) {
+            float kts = wind[c];
+            Uint32 px = o->ramp[kts <= 0.0f ? 0 : kts >= RAMP_KTS - 1 ? RAMP_KTS - 1 : (int)kts];
+            row[c] = px;
+            if (px) { if (c < rowMin) rowMin = c; rowMax = c; }
+        }
+        if (rowMax < 0) continue;
+        if (r < minR) minR = r;
+        maxR = r;
+        if (rowMin < minC) minC = rowMin;
+        if (rowMax > maxC) maxC = rowMax;
+    }
+    SDL_UnlockTexture(o->tex);
+    o->extent = maxR < 0 ? (SDL_Rect){ 0, 0, 0, 0 } : (SDL_Rect){ minC, minR, maxC - minC + 1, maxR - minR + 1 };
+    return 1;
+}
+
+void weatherOverlayDraw(WeatherOverlay* o, int x, int y, float zoom) {
+    if (!o || !weatherGrid) return;
+    unsigned rev = weatherRevision();
+    if (!o->baked || o->revision != rev) {
+        o->baked = bake(o);
+        o->revision = rev;
+    }
+    if (!o->baked || o->extent.w == 0 || zoom <= 0.0f) return;
+
+    // Screen pixels per cell; the columns and rows of the extent that land on screen.
+    float cellPx = GRID_SCALE * zoom;
+    int screenW, screenH;
+    if (SDL_GetRendererOutputSize(o->ren, &screenW, &screenH) != 0) return;
+    int c0 = o->extent.x, c1 = o->extent.x + o->extent.w;
+    int r0 = o->extent.y, r1 = o->extent.y + o->extent.h;
+    int vc0 = (int)floorf(-x / cellPx), vc1 = (int)ceilf((screenW - x) / cellPx);
+    int vr0 = (int)floorf(-y / cellPx), vr1 = (int)ceilf((screenH - y) / cellPx);
+    if (vc0 > c0) c0 = vc0;
+    if (vc1 < c1) c1 = vc1;
+    if (vr0 > r0) r0 = vr0;
+    if (vr1 < r1) r1 = vr1;
+    if (c0 >= c1 || r0 >= r1) return;
+
+    SDL_Rect src = { c0, r0, c1 - c0, r1 - r0 };
+    int left = x + (int)floorf(c0 * cellPx), top = y + (int)floorf(r0 * cellPx);
+    SDL_Rect dst = { left, top, x + (int)floorf(c1 * cellPx) - left, y + (int)floorf(r1 * cellPx) - top };
+    SDL_RenderCopy(o->ren, o->tex, &src, &dst);
+}
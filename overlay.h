@@ -0,0 +1,25 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+// Weather overlay for the viewer (storm2.c): weatherGrid baked into a texture, one
+// texel per grid cell coloured by wind speed. It is baked again only when
+// weatherRevision() moves on, and a frame costs a texture copy per visible map copy,
+// clipped to the storms' extent and the screen, however large the storms are.
+#include <SDL2/SDL.h>
+
+// A colour at a wind speed; between stops colours are interpolated, below the first
+// stop nothing is drawn and above the last its colour holds.
+typedef struct { float kts; SDL_Color color; } WindColor;
+
+typedef struct WeatherOverlay WeatherOverlay;
+
+WeatherOverlay* weatherOverlayCreate(SDL_Renderer* ren);
+void weatherOverlayFree(WeatherOverlay* o);
+// Replaces the default ramp (faint yellow at 20 kts through red at 64 to purple);
+// stops in increasing kts, at most 16.
+void weatherOverlaySetRamp(WeatherOverlay* o, const WindColor* stops, int count);
+// Draws the map copy whose top-left corner is at screen x, y, at zoom screen pixels per
+// map pixel. Bakes first if the weather changed.
+void weatherOverlayDraw(WeatherOverlay* o, int x, int y, float zoom);
+
+#endif
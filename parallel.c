@@ -0,0 +1,100 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define MAX_WORKERS 64
+
+static int workerOverride = 0;
+
+int parallelWorkers() {
+    if (workerOverride > 0) return workerOverride;
+    static int cpus = 0;
+    if (!cpus) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        cpus = (int)info.dwNumberOfProcessors;
+#else
+        cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (cpus < 1) cpus = 1;
+        if (cpus > MAX_WORKERS) cpus = MAX_WORKERS;
+    }
+    return cpus;
+}
+
+void setParallelWorkers(int workers) {
+    workerOverride = workers > MAX_WORKERS ? MAX_WORKERS : workers;
+}
+
+typedef struct {
+    RangeFn fn;
+    void* arg;
+    int begin, end;
+} RangeJob;
+
+static void* runRange(void* p) {
+    RangeJob* job = (RangeJob*)p;
+    job->fn(job->arg, job->begin, job->end);
+    return NULL;
+}
+
+typedef struct {
+    WorkerFn fn;
+    void* arg;
+    int worker;
+} WorkerJob;
+
+static void* runWorker(void* p) {
+    WorkerJob* job = (WorkerJob*)p;
+    job->fn(job->arg, job->worker);
+    return NULL;
+}
+
+void parallelRun(int workers, WorkerFn fn, void* arg) {
+    if (workers > parallelWorkers()) workers = parallelWorkers();
+    if (workers <= 1) { if (workers == 1) fn(arg, 0); return; }
+
+    WorkerJob jobs[MAX_WORKERS];
+    pthread_t threads[MAX_WORKERS];
+    int started[MAX_WORKERS] = { 0 };
+    for (int w = 0; w < workers; w++) { jobs[w].fn = fn; jobs[w].arg = arg; jobs[w].worker = w; }
+    for (int w = 1; w < workers; w++)
+        started[w] = pthread_create(&threads[w], NULL, runWorker, &jobs[w]) == 0;
+    runWorker(&jobs[0]);
+    // A worker that failed to start runs here instead; its share of the work has
+    // usually been taken by the others by then.
+    for (int w = 1; w < workers; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+        else runWorker(&jobs[w]);
+    }
+}
+
+void parallelFor(int count, RangeFn fn, void* arg) {
+    int workers = parallelWorkers();
+    if (workers > count) workers = count;
+    if (workers <= 1) { if (count > 0) fn(arg, 0, count); return; }
+
+    RangeJob jobs[MAX_WORKERS];
+    pthread_t threads[MAX_WORKERS];
+    int started[MAX_WORKERS] = { 0 };
+    for (int w = 0; w < workers; w++) {
+        jobs[w].fn = fn; jobs[w].arg = arg;
+        jobs[w].begin = (int)((long long)count * w / workers);
+        jobs[w].end = (int)((long long)count * (w + 1) / workers);
+    }
+    for (int w = 1; w < workers; w++)
+        started[w] = pthread_create(&threads[w], NULL, runRange, &jobs[w]) == 0;
+    runRange(&jobs[0]);
+    // A worker that failed to start has its range run here instead.
+    for (int w = 1; w < workers; w++) {
+        if (started[w]) pthread_join(threads[w], NULL);
+        else runRange(&jobs[w]);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Fork-join helpers for the grid preprocessing passes (coastal distance, weather) and
+// the port matrix.
+// Uses pthreads, which MinGW-w64 provides as winpthreads.
+
+// Runs fn over [0, count) split into one contiguous range per worker, and returns
+// when every range is done. The calling thread takes the first range.
+typedef void (*RangeFn)(void* arg, int begin, int end);
+void parallelFor(int count, RangeFn fn, void* arg);
+// Runs fn(arg, worker) for worker = 0 .. workers-1, one thread each (at most
+// parallelWorkers()), and returns when all are done; worker 0 is the calling thread.
+// For jobs that share out their own work, e.g. items claimed from an atomic counter.
+typedef void (*WorkerFn)(void* arg, int worker);
+void parallelRun(int workers, WorkerFn fn, void* arg);
+// Number of workers parallelFor() uses: the online CPU count unless overridden.
+int parallelWorkers(void);
+// 0 restores the CPU count.
+void setParallelWorkers(int workers);
+
+#endif
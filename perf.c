@@ -0,0 +1,138 @@
+#include "perf.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Counters are atomics, added to by whichever thread finishes a search. Phases are
+// few per frame and mostly on the main thread, so they share one lock with the trace.
+
+static atomic_llong counters[PERF_COUNTERS];
+static PerfPhaseStats phases[PERF_PHASES];
+static double pendingMs[PERF_PHASES];     // this frame so far
+static long long frames = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE* trace = NULL;
+static double traceStart = 0;
+
+static const char* counterNames[PERF_COUNTERS] = {
+    "searches", "expanded", "pushes", "pops", "stale_pops", "peak_open", "search_us"
+};
+static const char* phaseNames[PERF_PHASES] = {
+    "grid_load", "grid_build", "coast", "weather", "derived",
+    "frame", "draw_chart", "draw_overlay", "draw_route", "draw_text", "present"
+};
+
+double perfNow() {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return now.QuadPart * 1000.0 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+void perfCountSearch(long long expanded, long long pushes, long long pops, long long peakOpen, double ms) {
+    atomic_fetch_add(&counters[PERF_SEARCHES], 1);
+    atomic_fetch_add(&counters[PERF_EXPANDED], expanded);
+    atomic_fetch_add(&counters[PERF_PUSHES], pushes);
+    atomic_fetch_add(&counters[PERF_POPS], pops);
+    if (pops > expanded) atomic_fetch_add(&counters[PERF_STALE_POPS], pops - expanded);
+    atomic_fetch_add(&counters[PERF_SEARCH_US], (long long)(ms * 1000.0));
+    long long peak = atomic_load(&counters[PERF_PEAK_OPEN]);
+    while (peakOpen > peak && !atomic_compare_exchange_weak(&counters[PERF_PEAK_OPEN], &peak, peakOpen)) {}
+}
+
+void perfPhaseAdd(PerfPhase phase, double ms) {
+    pthread_mutex_lock(&lock);
+    PerfPhaseStats* s = &phases[phase];
+    s->lastMs = ms;
+    if (ms > s->maxMs) s->maxMs = ms;
+    s->totalMs += ms;
+    s->count++;
+    pendingMs[phase] += ms;
+    pthread_mutex_unlock(&lock);
+}
+
+void perfEndFrame() {
+    pthread_mutex_lock(&lock);
+    for (int i = PERF_FIRST_FRAME_PHASE; i < PERF_PHASES; i++) {
+        phases[i].frameMs = pendingMs[i];
+        pendingMs[i] = 0;
+    }
+    frames++;
+    pthread_mutex_unlock(&lock);
+}
+
+void perfSnapshot(PerfSnapshot* out) {
+    for (int i = 0; i < PERF_COUNTERS; i++) out->counters[i] = atomic_load(&counters[i]);
+    pthread_mutex_lock(&lock);
+    memcpy(out->phases, phases, sizeof(phases));
+    out->frames = frames;
+    pthread_mutex_unlock(&lock);
+}
+
+void perfReset() {
+    for (int i = 0; i < PERF_COUNTERS; i++) atomic_store(&counters[i], 0);
+    pthread_mutex_lock(&lock);
+    memset(phases, 0, sizeof(phases));
+    memset(pendingMs, 0, sizeof(pendingMs));
+    frames = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+const char* perfCounterName(PerfCounter counter) {
+    return counter >= 0 && counter < PERF_COUNTERS ? counterNames[counter] : "";
+}
+
+const char* perfPhaseName(PerfPhase phase) {
+    return phase >= 0 && phase < PERF_PHASES ? phaseNames[phase] : "";
+}
+
+// --- CSV Trace ---
+int perfTraceOpen(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return 0;
+    fprintf(f, "ms,label");
+    for (int i = 0; i < PERF_COUNTERS; i++) fprintf(f, ",%s", counterNames[i]);
+    for (int i = 0; i < PERF_PHASES; i++) fprintf(f, ",%s_ms", phaseNames[i]);
+    fprintf(f, "\n");
+    pthread_mutex_lock(&lock);
+    if (trace) fclose(trace);
+    trace = f;
+    traceStart = perfNow();
+    pthread_mutex_unlock(&lock);
+    return 1;
+}
+
+void perfTraceRow(const char* label) {
+    PerfSnapshot snap;
+    perfSnapshot(&snap);
+    pthread_mutex_lock(&lock);
+    if (trace) {
+        fprintf(trace, "%.3f,%s", perfNow() - traceStart, label);
+        for (int i = 0; i < PERF_COUNTERS; i++) fprintf(trace, ",%lld", snap.counters[i]);
+        for (int i = 0; i < PERF_PHASES; i++)
+            fprintf(trace, ",%.3f", i < PERF_FIRST_FRAME_PHASE ? snap.phases[i].lastMs : snap.phases[i].frameMs);
+        fprintf(trace, "\n");
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void perfTraceClose() {
+    pthread_mutex_lock(&lock);
+    if (trace) fclose(trace);
+    trace = NULL;
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,84 @@
+#ifndef PERF_H
+#define PERF_H
+
+// Performance counters and phase timers for the routing core and the viewers.
+// Searches tally their open-list traffic in the structure they already own and add
+// it here once, when they finish, so a query pays one atomic add per counter rather
+// than one per push. Phases are timed with PERF_TIMER()/PERF_PHASE() around the work;
+// the per-frame ones (PERF_FRAME and after) are summed over a frame and published by
+// perfEndFrame(). perfTraceRow() appends a snapshot to a CSV trace.
+// Build with -DNO_PERF to compile all of it out: the macros expand to nothing and the
+// counters read zero.
+
+typedef enum {
+    PERF_SEARCHES,
+    PERF_EXPANDED,
+    PERF_PUSHES,        // open-list pushes
+    PERF_POPS,
+    PERF_STALE_POPS,    // pops that expanded nothing: superseded duplicates, requeues
+    PERF_PEAK_OPEN,     // the largest open list of any search, not a sum
+    PERF_SEARCH_US,     // wall time in searches, summed over threads
+    PERF_COUNTERS
+} PerfCounter;
+
+typedef enum {
+    // Startup and weather changes.
+    PERF_GRID_LOAD,     // mapping a compiled grid
+    PERF_GRID_BUILD,    // classifying the chart's pixels
+    PERF_COAST,         // coastal padding
+    PERF_WEATHER,       // wind field
+    PERF_DERIVED,       // cost field and the tables built on it
+    // The viewer's frame.
+    PERF_FRAME,         // everything but the present
+    PERF_DRAW_CHART,
+    PERF_DRAW_OVERLAY,
+    PERF_DRAW_ROUTE,
+    PERF_DRAW_TEXT,     // labels and panels
+    PERF_PRESENT,
+    PERF_PHASES
+} PerfPhase;
+
+#define PERF_FIRST_FRAME_PHASE PERF_FRAME
+
+typedef struct {
+    double lastMs;      // the latest run
+    double frameMs;     // summed over the last finished frame
+    double maxMs;
+    double totalMs;
+    long long count;
+} PerfPhaseStats;
+
+typedef struct {
+    long long counters[PERF_COUNTERS];
+    PerfPhaseStats phases[PERF_PHASES];
+    long long frames;
+} PerfSnapshot;
+
+// Milliseconds on a monotonic clock.
+double perfNow(void);
+void perfCountSearch(long long expanded, long long pushes, long long pops, long long peakOpen, double ms);
+void perfPhaseAdd(PerfPhase phase, double ms);
+void perfEndFrame(void);
+void perfSnapshot(PerfSnapshot* out);
+void perfReset(void);
+const char* perfCounterName(PerfCounter counter);
+const char* perfPhaseName(PerfPhase phase);
+// The trace has one column per counter (running totals, so rows subtract) and per
+// phase (its latest run; the frame phases their last frame). 0 if path can't be opened.
+int perfTraceOpen(const char* path);
+void perfTraceRow(const char* label);
+void perfTraceClose(void);
+
+#ifndef NO_PERF
+#define PERF_ONLY(...) __VA_ARGS__
+#define PERF_TIMER(t) double t = perfNow()
+#define PERF_PHASE(phase, t) perfPhaseAdd(phase, perfNow() - (t))
+#define PERF_SEARCH(expanded, pushes, pops, peakOpen, t) perfCountSearch(expanded, pushes, pops, peakOpen, perfNow() - (t))
+#else
+#define PERF_ONLY(...)
+#define PERF_TIMER(t)
+#define PERF_PHASE(phase, t)
+#define PERF_SEARCH(expanded, pushes, pops, peakOpen, t)
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#include "perfoverlay.h"
+#include "perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// The figures are formatted into lines on refresh and the same lines drawn every frame
+// in between. Searches are counted whatever thread ran them; the frame phases come
+// from storm2.c's own timers.
+
+#define REFRESH_MS 250
+#define PANEL_LINES 9
+
+struct PerfOverlay {
+    SDL_Renderer* ren;
+    Uint32 lastRefresh;
+    PerfSnapshot last;          // at the last refresh, for the per-frame averages
+    char lines[PANEL_LINES][96];
+};
+
+PerfOverlay* perfOverlayCreate(SDL_Renderer* ren) {
+    PerfOverlay* po = (PerfOverlay*)calloc(1, sizeof(PerfOverlay));
+    if (po) po->ren = ren;
+    return po;
+}
+
+void perfOverlayFree(PerfOverlay* po) {
+    free(po);
+}
+
+// Large counts as 12.3k / 4.56M.
+static const char* shortCount(long long v, char* buf, int size) {
+    if (v >= 10000000) snprintf(buf, size, "%.1fM", v / 1e6);
+    else if (v >= 1000000) snprintf(buf, size, "%.2fM", v / 1e6);
+    else if (v >= 10000) snprintf(buf, size, "%.1fk", v / 1e3);
+    else snprintf(buf, size, "%lld", v);
+    return buf;
+}
+
+static void refresh(PerfOverlay* po, Uint32 now) {
+    PerfSnapshot s;
+    perfSnapshot(&s);
+    const long long* c = s.counters;
+    char a[16], b[16], d[16];
+    snprintf(po->lines[0], sizeof(po->lines[0]), "Searches %lld  expanded %s", c[PERF_SEARCHES],
+             shortCount(c[PERF_EXPANDED], a, sizeof(a)));
+    snprintf(po->lines[1], sizeof(po->lines[1]), "Pushes %s  pops %s  stale %s", shortCount(c[PERF_PUSHES], a, sizeof(a)),
+             shortCount(c[PERF_POPS], b, sizeof(b)), shortCount(c[PERF_STALE_POPS], d, sizeof(d)));
+    snprintf(po->lines[2], sizeof(po->lines[2]), "Open peak %s  search %.1f ms", shortCount(c[PERF_PEAK_OPEN], a, sizeof(a)),
+             c[PERF_SEARCH_US] / 1000.0);
+    const PerfPhaseStats* p = s.phases;
+    snprintf(po->lines[3], sizeof(po->lines[3]), "Load %.1f  build %.1f  coast %.1f ms", p[PERF_GRID_LOAD].lastMs,
+             p[PERF_GRID_BUILD].lastMs, p[PERF_COAST].lastMs);
+    snprintf(po->lines[4], sizeof(po->lines[4]), "Weather %.1f  derived %.1f ms", p[PERF_WEATHER].lastMs, p[PERF_DERIVED].lastMs);
+
+    // Averages over the frames since the last refresh.
+    long long frames = s.frames - po->last.frames;
+    double avg[PERF_PHASES] = { 0 };
+    for (int i = PERF_FIRST_FRAME_PHASE; i < PERF_PHASES && frames > 0; i++)
+        avg[i] = (p[i].totalMs - po->last.phases[i].totalMs) / frames;
+    double fps = frames > 0 && now > po->lastRefresh ? frames * 1000.0 / (now - po->lastRefresh) : 0;
+    snprintf(po->lines[5], sizeof(po->lines[5]), "Frame %.2f ms  %.0f fps", avg[PERF_FRAME], fps);
+    snprintf(po->lines[6], sizeof(po->lines[6]), "Chart %.2f  overlay %.2f ms", avg[PERF_DRAW_CHART], avg[PERF_DRAW_OVERLAY]);
+    snprintf(po->lines[7], sizeof(po->lines[7]), "Route %.2f  text %.2f ms", avg[PERF_DRAW_ROUTE], avg[PERF_DRAW_TEXT]);
+    snprintf(po->lines[8], sizeof(po->lines[8]), "Present %.2f ms", avg[PERF_PRESENT]);
+    po->last = s;
+    po->lastRefresh = now;
+}
+
+int perfOverlayDraw(PerfOverlay* po, TextCache* text, TTF_Font* font, int x, int y, int w) {
+    if (!po || !font) return 0;
+    Uint32 now = SDL_GetTicks();
+    if (!po->lastRefresh || now - po->lastRefresh >= REFRESH_MS) refresh(po, now);
+    int lineH = TTF_FontHeight(font) + 2;
+    SDL_Rect panel = { x, y, w, PANEL_LINES * lineH + 12 };
+    SDL_SetRenderDrawColor(po->ren, 9, 27, 71, 230);
+    SDL_RenderFillRect(po->ren, &panel);
+    SDL_SetRenderDrawColor(po->ren, 255, 255, 255, 255);
+    SDL_RenderDrawRect(po->ren, &panel);
+    for (int i = 0; i < PANEL_LINES; i++) {
+        SDL_Color color = i < 3 ? (SDL_Color){ 255, 255, 255, 255 } : i < 5 ? (SDL_Color){ 160, 200, 255, 255 } : (SDL_Color){ 200, 200, 200, 255 };
+        textDrawGlyphs(text, font, po->lines[i], color, x + 10, y + 6 + i * lineH);
+    }
+    return panel.h;
+}
@@ -0,0 +1,19 @@
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+// Profiling panel for the viewer (storm2.c): the search counters of perf.h, the
+// startup phases and the frame broken down by phase. Frame times are averaged over
+// the frames since the panel last refreshed its figures, a few times a second, so
+// the numbers can be read; they are drawn from the glyph atlas (see textcache.h).
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "textcache.h"
+
+typedef struct PerfOverlay PerfOverlay;
+
+PerfOverlay* perfOverlayCreate(SDL_Renderer* ren);
+void perfOverlayFree(PerfOverlay* po);
+// Draws the panel w pixels wide with its top-left corner at x, y; returns its height.
+int perfOverlayDraw(PerfOverlay* po, TextCache* text, TTF_Font* font, int x, int y, int w);
+
+#endif
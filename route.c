@@ -0,0 +1,359 @@
+#include "searchctx.h"
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// --- Globals ---
+unsigned char* collisionGrid = NULL;
+float* weatherGrid = NULL;
+int gridW, gridH;
+int mapWidth, mapHeight;
+int wrapColumns = 0;
+
+// --- Coordinate Helpers (Mapped to User Bounding Box) ---
+float pixelToLat(float pixel_y) {
+    float wy = pixel_y - mapHeight/2.0f;
+    // Mercator: lat = 2 * atan(exp((y - c) / m)) - pi/2
+    // Precise derivation: m = 26.61, c = 3.11
+    return (2.0f * atanf(expf((wy - 3.11f) / 26.61f)) - (float)M_PI / 2.0f) * 180.0f / (float)M_PI;
+}
+
+float pixelToLon(float pixel_x) {
+    float wx = pixel_x - mapWidth/2.0f;
+    // Linear: Lon = (x - c) / m
+    // Precise derivation: m = 0.5581, c = 78.85
+    return (wx - 78.85f) / 0.5581f;
+}
+
+// Inverses of the two calibrations above, used to place lat/lon input on the grid.
+float latToPixel(float lat) {
+    float phi = lat * (float)M_PI / 180.0f;
+    return 26.61f * logf(tanf((float)M_PI / 4.0f + phi / 2.0f)) + 3.11f + mapHeight/2.0f;
+}
+
+float lonToPixel(float lon) {
+    return lon * 0.5581f + 78.85f + mapWidth/2.0f;
+}
+
+GridPos worldToGrid(float wx, float wy) {
+    return (GridPos){ (int)(wy + mapHeight/2) / GRID_SCALE, (int)(wx + mapWidth/2) / GRID_SCALE };
+}
+
+// --- Cost Field ---
+uint16_t* costField = NULL;
+
+uint16_t cellCost(unsigned char cell, float wind) {
+    if (cell == 1) return COST_LAND;
+    float penalty = cell == 2 ? PADDING_COST : 0.0f;
+    // --- WEATHER PENALTY ---
+    if (wind > STORM_THRESHOLD) penalty += wind * 8.0f; // Penalize storms to force routing around them
+    float units = penalty * COST_SCALE + 0.5f;
+    return units >= COST_LAND - 1 ? COST_LAND - 1 : (uint16_t)units;
+}
+
+void updateCostField() {
+    int cells = gridW * gridH;
+    costField = (uint16_t*)realloc(costField, cells * sizeof(uint16_t));
+    for (int i = 0; i < cells; i++) costField[i] = cellCost(collisionGrid[i], weatherGrid[i]);
+}
+
+void prepareSearch(SearchMode mode) {
+    if (!collisionGrid) return;
+    if (mode == SEARCH_JPS && !jumpMask) updateJumpMask();
+    if (mode == SEARCH_HPA && !hierarchyBuilt()) buildHierarchy();
+}
+
+static unsigned weatherRev = 0;
+
+unsigned weatherRevision() { return weatherRev; }
+
+void refreshDerivedGrids() {
+    if (!collisionGrid || !weatherGrid) return;
+    PERF_TIMER(t0);
+    weatherRev++;
+    updateCostField();
+    if (jumpMask) updateJumpMask();   // otherwise built on the first JPS query
+    refreshHierarchy();
+    refreshSightMasks();
+    PERF_PHASE(PERF_DERIVED, t0);
+}
+
+void setMapWraps(int wraps) {
+    wraps = wraps != 0;
+    if (wraps == wrapColumns) return;
+    wrapColumns = wraps;
+    // Tables built for the other topology.
+    if (jumpMask) updateJumpMask();
+    if (hierarchyBuilt()) buildHierarchy();
+    freeLandmarks();
+}
+
+int mapWraps() { return wrapColumns; }
+
+// --- Grid Building ---
+static uint32_t waterRgb = 0x262626;
+static int waterTol = 0;
+
+void setWaterColor(uint32_t rgb, int tolerance) {
+    waterRgb = rgb & 0xFFFFFF;
+    waterTol = tolerance < 0 ? 0 : tolerance;
+}
+
+uint32_t waterColor() { return waterRgb; }
+int waterTolerance() { return waterTol; }
+
+static inline int channelNear(int v, int ref) {
+    return v >= ref - waterTol && v <= ref + waterTol;
+}
+
+void createCollisionGrid(const uint32_t* pixels, int w, int h) {
+    freeCollisionGrid();
+    PERF_TIMER(t0);
+    mapWidth = w; mapHeight = h;
+    gridW = w / GRID_SCALE;
+    gridH = h / GRID_SCALE;
+    collisionGrid = (unsigned char*)malloc(gridW * gridH);
+    weatherGrid = (float*)calloc(gridW * gridH, sizeof(float));
+
+    for (int y = 0; y < gridH; y++) {
+        for (int x = 0; x < gridW; x++) {
+            uint32_t pixel = pixels[(y * GRID_SCALE * w) + (x * GRID_SCALE)];
+            int water = channelNear((pixel >> 16) & 0xFF, (waterRgb >> 16) & 0xFF) &&
+                        channelNear((pixel >> 8) & 0xFF, (waterRgb >> 8) & 0xFF) && channelNear(pixel & 0xFF, waterRgb & 0xFF);
+            collisionGrid[y * gridW + x] = water ? 0 : 1;
+        }
+    }
+    PERF_PHASE(PERF_GRID_BUILD, t0);
+    markCoastalPadding();
+    updateWeatherSimulation();
+}
+
+void freeCollisionGrid() {
+    if (!releaseCompiledGrid()) free(collisionGrid);
+    collisionGrid = NULL;
+    free(jumpMask); jumpMask = NULL;
+    free(jumpDist); jumpDist = NULL;
+    free(costField); costField = NULL;
+    freeSightMasks();
+    freeForecast();
+    refreshHierarchy();
+    freeLandmarks();
+    free(weatherGrid); weatherGrid = NULL;
+    weatherRev++;
+    gridW = gridH = 0;
+}
+
+// --- Search ---
+int snapToWater(float* wx, float* wy) {
+    if (wrapColumns && gridW > 0) {
+        // Bring a point given past either edge of a wrapping chart back onto it.
+        float span = (float)(gridW * GRID_SCALE), x = fmodf(*wx + mapWidth/2.0f, span);
+        *wx = (x < 0 ? x + span : x) - mapWidth/2.0f;
+    }
+    GridPos p = worldToGrid(*wx, *wy);
+    int c = p.c, r = p.r;
+    if (r >= 0 && r < gridH && c >= 0 && c < gridW && collisionGrid[r * gridW + c] != 1) return 1;
+    for (int radius = 1; radius < 25; radius++) {
+        for (int dr = -radius; dr <= radius; dr++) {
+            for (int dc = -radius; dc <= radius; dc++) {
+                int nr = r + dr, nc = c + dc;
+                if (wrapColumns && gridW > 0) nc = (nc % gridW + gridW) % gridW;
+                if (nr >= 0 && nr < gridH && nc >= 0 && nc < gridW && collisionGrid[nr * gridW + nc] != 1) {
+                    *wx = (nc * GRID_SCALE) - mapWidth/2.0f + (GRID_SCALE/2.0f);
+                    *wy = (nr * GRID_SCALE) - mapHeight/2.0f + (GRID_SCALE/2.0f);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// --- Search Context ---
+SearchContext* searchContextCreate() {
+    SearchContext* ctx = (SearchContext*)calloc(1, sizeof(SearchContext));
+    if (ctx) ctx->departure = -1.0f;
+    return ctx;
+}
+
+void searchContextFree(SearchContext* ctx) {
+    if (!ctx) return;
+    free(ctx->g); free(ctx->parent); free(ctx->stamp); free(ctx->arrival);
+    openListFree(&ctx->openList);
+    hpaScratchFree(ctx->hpa);
+    free(ctx);
+}
+
+void searchContextSetOpenList(SearchContext* ctx, OpenListKind kind) {
+    ctx->openKind = kind;
+}
+
+void searchContextSetMode(SearchContext* ctx, SearchMode mode) {
+    ctx->mode = mode;
+}
+
+void searchContextSetHeuristic(SearchContext* ctx, HeuristicKind kind) {
+    ctx->heuristic = kind;
+}
+
+void searchContextSetDeparture(SearchContext* ctx, float hours) {
+    ctx->departure = hours;
+}
+
+void beginSearch(SearchContext* ctx) {
+    int cells = gridW * gridH;
+    if (ctx->cells != cells) {
+        free(ctx->g); free(ctx->parent); free(ctx->stamp);
+        free(ctx->arrival); ctx->arrival = NULL;    // allocated by the first timed query
+        ctx->g = (float*)malloc(cells * sizeof(float));
+        ctx->parent = (int32_t*)malloc(cells * sizeof(int32_t));
+        ctx->stamp = (uint32_t*)calloc(cells, sizeof(uint32_t));
+        ctx->cells = cells;
+        ctx->generation = 0;
+    }
+    if (ctx->openList.cells != cells || ctx->openList.kind != ctx->openKind) {
+        openListFree(&ctx->openList);
+        openListInit(&ctx->openList, ctx->openKind, cells);
+    }
+    else openListClear(&ctx->openList);
+    if (++ctx->generation == 0) {
+        memset(ctx->stamp, 0, cells * sizeof(uint32_t));
+        ctx->generation = 1;
+    }
+}
+
+static int segmentSteps(int from, int to) {
+    int dr = abs(to / gridW - from / gridW), dc = columnGap(to % gridW, from % gridW);
+    return dr > dc ? dr : dc;
+}
+
+void buildPath(const int32_t* parent, int idx, RoutePath* out) {
+    out->len = 1;
+    for (int i = idx; parent[i] >= 0; i = parent[i]) out->len += segmentSteps(parent[i], i);
+    out->cells = malloc(sizeof(GridPos) * out->len);
+    int n = out->len;
+    for (int i = idx; i >= 0; i = parent[i]) {
+        GridPos p = { i / gridW, i % gridW };
+        out->cells[--n] = p;
+        if (parent[i] < 0) break;
+        GridPos q = { parent[i] / gridW, parent[i] % gridW };
+        // On a wrapping chart a segment may cross the seam; walk it the short way round.
+        int dc = q.c - p.c;
+        if (wrapColumns && 2 * abs(dc) > gridW) dc += dc > 0 ? -gridW : gridW;
+        int sr = (q.r > p.r) - (q.r < p.r), sc = (dc > 0) - (dc < 0);
+        int ar = abs(q.r - p.r), ac = abs(dc);
+        int straight = abs(ar - ac);
+        for (int k = segmentSteps(parent[i], i) - 1; k > 0; k--) {
+            // Walking back from the child: the straight leg first, then the diagonal.
+            if (straight > 0) { if (ar > ac) p.r += sr; else p.c = stepColumn(p.c + sc); straight--; }
+            else { p.r += sr; p.c = stepColumn(p.c + sc); }
+            out->cells[--n] = p;
+        }
+    }
+}
+
+static SearchContext* defaultContext = NULL;
+
+int astar(GridPos start, GridPos goal, RoutePath* out) {
+    if (!defaultContext) defaultContext = searchContextCreate();
+    return astarSearch(defaultContext, start, goal, out);
+}
+
+static int routeSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out) {
+    out->cells = NULL; out->len = 0; out->cost = 0; out->expanded = 0; out->hours = 0;
+    if (!collisionGrid) return 0;
+    if (start.r < 0 || start.r >= gridH || start.c < 0 || start.c >= gridW) return 0;
+    if (goal.r < 0 || goal.r >= gridH || goal.c < 0 || goal.c >= gridW) return 0;
+    if (collisionGrid[start.r * gridW + start.c] == 1 || collisionGrid[goal.r * gridW + goal.c] == 1) return 0;
+    if (ctx->departure >= 0 && forecastSteps() > 0 && serviceSpeed() > 0) return timedSearch(ctx, start, goal, out);
+    if (ctx->mode == SEARCH_JPS) return jpsSearch(ctx, start, goal, out);
+    if (ctx->mode == SEARCH_HPA) return hpaSearch(ctx, start, goal, out);
+    return astarGridSearch(ctx, start, goal, out);
+}
+
+float routeHours(const RoutePath* path) {
+    float speed = serviceSpeed(), cells = 0;
+    if (speed <= 0) return 0;
+    for (int i = 1; i < path->len; i++) {
+        int diagonal = path->cells[i].r != path->cells[i - 1].r && path->cells[i].c != path->cells[i - 1].c;
+        cells += diagonal ? STEP_DIAGONAL : STEP_STRAIGHT;
+    }
+    return cells * nmPerCell() / speed;
+}
+
+int astarSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out) {
+    PERF_TIMER(t0);
+    PERF_ONLY(OpenList* ol = &ctx->openList; ol->pushes = ol->pops = 0; ol->peak = 0;)
+    int found = routeSearch(ctx, start, goal, out);
+    if (found && out->hours == 0) out->hours = routeHours(out);
+    PERF_SEARCH(out->expanded, ol->pushes, ol->pops, ol->peak, t0);
+    return found;
+}
+
+// Same visiting order as the old dr/dc double loop.
+const int neighbourDr[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+const int neighbourDc[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+const float neighbourStep[8] = {
+    STEP_DIAGONAL, STEP_STRAIGHT, STEP_DIAGONAL, STEP_STRAIGHT, STEP_STRAIGHT, STEP_DIAGONAL, STEP_STRAIGHT, STEP_DIAGONAL
+};
+
+int astarGridSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out) {
+    int endR = goal.r, endC = goal.c;
+
+    beginSearch(ctx);
+    OpenList* openList = &ctx->openList;
+    float* gScore = ctx->g;
+    int32_t* parent = ctx->parent;
+    uint32_t* stamp = ctx->stamp;
+    uint32_t gen = ctx->generation;
+
+    int startIdx = start.r * gridW + start.c;
+    int goalIdx = endR * gridW + endC;
+    beginHeuristic(ctx, goalIdx);
+    stamp[startIdx] = gen;
+    gScore[startIdx] = 0;
+    parent[startIdx] = -1;
+    openPush(openList, startIdx, heuristic(ctx, start.r, start.c, endR, endC));
+
+    int found = 0, currIdx;
+    float currF;
+    while ((currIdx = openPop(openList, &currF)) >= 0) {
+        int currR = currIdx / gridW, currC = currIdx % gridW;
+        float currG = gScore[currIdx];
+        if (currF > currG + heuristic(ctx, currR, currC, endR, endC)) continue; // superseded duplicate
+        out->expanded++;
+        if (currIdx == goalIdx) {
+            found = 1;
+            out->cost = currG;
+            buildPath(parent, currIdx, out);
+            break;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            int nr = currR + neighbourDr[k], nc = stepColumn(currC + neighbourDc[k]);
+            if (nr < 0 || nr >= gridH || nc < 0) continue;
+            int idx = nr * gridW + nc;
+            uint16_t penalty = costField[idx];
+            if (penalty == COST_LAND) continue;
+
+            float tentativeG = currG + (neighbourStep[k] + penalty * (1.0f / COST_SCALE));
+            if (stamp[idx] != gen || tentativeG < gScore[idx]) {
+                stamp[idx] = gen;
+                gScore[idx] = tentativeG;
+                parent[idx] = currIdx;
+                openPush(openList, idx, tentativeG + heuristic(ctx, nr, nc, endR, endC));
+            }
+        }
+    }
+    return found;
+}
+
+void freePath(RoutePath* path) {
+    free(path->cells);
+    path->cells = NULL; path->len = 0; path->cost = 0;
+}
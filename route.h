@@ -0,0 +1,254 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+// Headless routing core shared by the viewer (storm2.c) and the batch tools.
+// Nothing in here may include SDL.
+#include <stdint.h>
+
+#define GRID_SCALE 4
+#define PADDING_COST 50.0f
+#define STORM_THRESHOLD 30.0f
+#define ALT_MAX_LANDMARKS 64
+
+typedef struct { int r, c; } GridPos;
+// hours: sailing time at serviceSpeed() (0 when no speed is set).
+typedef struct { GridPos* cells; int len; float cost; int expanded; float hours; } RoutePath;
+
+// Open-list backend used by a SearchContext (see openlist.c).
+typedef enum {
+    OPEN_BINARY_HEAP,   // binary heap with duplicate pushes
+    OPEN_QUAD_HEAP,     // indexed 4-ary heap with decrease-key
+    OPEN_RADIX_HEAP     // monotone radix heap over fixed-point f
+} OpenListKind;
+
+typedef enum {
+    SEARCH_ASTAR,       // plain 8-neighbour expansion
+    SEARCH_JPS,         // jump point search across open water, plain expansion near coasts/storms
+    SEARCH_HPA          // cluster hierarchy; hops between neighbouring clusters search their
+                        // box first. Routes cost ~2-3% more than optimal on average, up to
+                        // ~15% (see hpa.c)
+} SearchMode;
+
+typedef enum {
+    HEURISTIC_WEIGHTED_EUCLID,  // Euclidean x1.2: fast, not admissible
+    HEURISTIC_OCTILE,           // octile distance: admissible, routes are optimal
+    HEURISTIC_ALT               // landmark bounds (see buildLandmarks), octile until loaded
+} HeuristicKind;
+
+// --- Map State (read-only once the grid is built) ---
+extern unsigned char* collisionGrid;   // 0 water, 1 land, 2 coastal padding
+extern float* weatherGrid;             // wind speed (kts) per cell
+extern int gridW, gridH;
+extern int mapWidth, mapHeight;        // source image size in pixels
+
+// --- Coordinate Helpers ---
+float pixelToLat(float pixel_y);
+float pixelToLon(float pixel_x);
+float latToPixel(float lat);
+float lonToPixel(float lon);
+GridPos worldToGrid(float wx, float wy);
+
+// --- Grid Building ---
+// pixels: ARGB8888, w*h words, row-major.
+void createCollisionGrid(const uint32_t* pixels, int w, int h);
+// Pixels whose red, green and blue are each within tolerance of rgb (0xRRGGBB) are
+// water, everything else land. Takes effect on the next createCollisionGrid(). The
+// default is exactly 0x262626, the sea of assets/temp1.png; assets/temp2.png has a
+// light sea (0xFFFFFF, 40) under grey land.
+void setWaterColor(uint32_t rgb, int tolerance);
+uint32_t waterColor(void);
+int waterTolerance(void);
+// Water closer to land than this many nautical miles becomes padding (PADDING_COST per
+// step), converted to cells at each row's own scale (nmPerCellAtRow), so the margin
+// holds at every latitude. Takes effect on the next createCollisionGrid(). 0, the
+// default, keeps the classic ring of the 8 cells around land whatever the scale.
+void setCoastalMargin(float nm);
+float coastalMargin(void);
+// Nautical miles per grid cell, assuming the chart spans 360 degrees of longitude
+// (measured at the equator).
+float nmPerCell(void);
+// The same for row r of a Mercator chart: nmPerCell() * cos(latitude), with the
+// equator where it lies on assets/temp1.png and rows past 85 degrees taken at 85.
+float nmPerCellAtRow(int r);
+// Global charts: the last column borders the first, so searches, heuristics and
+// snapping cross the antimeridian instead of going the long way round. Off by default.
+// Search tables follow at once; padding on the next createCollisionGrid().
+void setMapWraps(int wraps);
+int mapWraps(void);
+void freeCollisionGrid(void);
+
+// --- Weather ---
+// Wind is peakWind (kts) within coreRadius degrees of the centre, tapering with the
+// squared distance to the ambient wind at radius; coreRadius == radius gives a flat
+// disc. Where storms overlap the strongest wind wins. Distances are in degrees of
+// lat/lon through pixelToLat/pixelToLon. The centre moves by driftLat/driftLon degrees
+// per hour; weatherGrid is the field at hour 0, buildForecast() the later ones.
+typedef struct { float lat, lon, radius, coreRadius, peakWind, driftLat, driftLon; } Storm;
+// Replaces the storm set (by default the single 55 kt storm at 35N 15E, 5 kt ambient).
+// Takes effect on the next updateWeatherSimulation().
+void setStorms(const Storm* list, int count, float ambient);
+// Copies up to max storms of the current set into list and returns how many there are;
+// ambient may be NULL.
+int currentStorms(Storm* list, int max, float* ambient);
+// Reads "lat lon radius peak [core [driftLat driftLon]]" lines and an optional
+// "ambient kts" line ('#' comments). Returns the number of storms, -1 if the file
+// cannot be read.
+int loadStorms(const char* path);
+// Rebuilds weatherGrid from the storm set, then everything derived from it.
+void updateWeatherSimulation(void);
+// Rebuilds what the searches derive from the grids (JPS tables, HPA* cluster costs)
+// once they exist; until then each is built on first use.
+// Call after editing collisionGrid or weatherGrid directly; updateWeatherSimulation()
+// already does.
+void refreshDerivedGrids(void);
+// Moves on with every refreshDerivedGrids() and grid change, so anything drawn from
+// weatherGrid can tell its copy is stale.
+unsigned weatherRevision(void);
+// Builds the tables a search mode needs now instead of on its first query.
+void prepareSearch(SearchMode mode);
+// Recomputes the HPA* cluster graph from scratch.
+void buildHierarchy(void);
+// Recomputes the cost tables of clusters whose cells changed since the last build, or
+// everything if land moved. No-op until the hierarchy exists. Returns clusters rebuilt.
+int refreshHierarchy(void);
+
+// --- Forecast (time-dependent routing) ---
+// Wind for hours 0, stepHours, 2*stepHours, ..., quantized to a byte per cell and step
+// in tiles; tiles of uniform wind take no space. A search with a departure time set
+// charges each cell from the step nearest the ship's arrival there.
+// From the storm set, moved along its drift. Call again after changing the storms;
+// steps <= 0 drops the forecast. Returns the steps built.
+int buildForecast(int steps, float stepHours);
+// From "hour,lat,lon,kts" lines sampling a regular lat/lon lattice at regular hours
+// ('#' comments); cells off the lattice are calm. Returns the steps, -1 if unreadable.
+int importForecastCsv(const char* path);
+// From steps consecutive gridW*gridH float32 (kts) fields. Returns the steps read, -1
+// if unreadable.
+int importForecastRaw(const char* path, int steps, float stepHours);
+// Writes the current forecast as a cube file.
+int saveForecast(const char* path);
+// Maps a cube file; tiles are read from disk only when a query touches them. Returns
+// the steps, 0 if the file is missing or was made for another grid or calibration.
+// Imported and loaded forecasts also replace weatherGrid with their first step.
+int loadForecast(const char* path);
+int forecastSteps(void);
+float forecastStepHours(void);
+// Wind (kts) at grid cell r, c in the step nearest hours; 0 without a forecast.
+float forecastWind(float hours, int r, int c);
+// Service speed in knots, used for arrival times and RoutePath.hours. 0 (the default)
+// disables both.
+void setServiceSpeed(float knots);
+float serviceSpeed(void);
+// Reads the speed=... field of a ship_info.txt line ("Name speed=14 kts mode=..."), sets
+// it and returns it; 0 if the file or field is missing.
+float loadShipSpeed(const char* path);
+
+// --- Compiled Grid ---
+// The finished collision grid (padding included) and map size, versioned and keyed to
+// the source image, so restarts skip the PNG decode and the grid build.
+// Content hash of a file, never 0 for a readable one; 0 if it cannot be read.
+uint64_t hashFile(const char* path);
+// Writes the current grid; sourceHash is hashFile() of the image it came from.
+int saveCompiledGrid(const char* path, uint64_t sourceHash);
+// Maps a compiled grid in place of createCollisionGrid(): collisionGrid then points into
+// the read-only mapping, shared by every process using the file. Returns 0 if the file
+// is missing, from another format version, GRID_SCALE or coastal margin, or built from
+// another image.
+int loadCompiledGrid(const char* path, uint64_t sourceHash);
+
+// --- Landmarks (ALT heuristic) ---
+// Picks count sea landmarks (at most ALT_MAX_LANDMARKS), computes their distance tables
+// and saves them to path (NULL: keep in memory only). Each landmark costs 2 bytes per
+// grid cell; more landmarks give tighter bounds and fewer expansions.
+int buildLandmarks(int count, const char* path);
+// Maps a table file written by buildLandmarks(). Returns 0 if it is missing, damaged
+// or was computed for a different collision grid.
+int loadLandmarks(const char* path);
+void freeLandmarks(void);
+// Landmarks usable with the current grid, 0 if none.
+int landmarkCount(void);
+
+// --- Search ---
+// Moves the world-space point onto the nearest navigable cell. Returns 0 if none within reach.
+int snapToWater(float* wx, float* wy);
+// Reusable per-thread scratch space; query cost scales with the cells visited,
+// not the map size. Resizes itself if the grid changes.
+typedef struct SearchContext SearchContext;
+SearchContext* searchContextCreate(void);
+void searchContextFree(SearchContext* ctx);
+void searchContextSetOpenList(SearchContext* ctx, OpenListKind kind);
+void searchContextSetMode(SearchContext* ctx, SearchMode mode);
+void searchContextSetHeuristic(SearchContext* ctx, HeuristicKind kind);
+// Routes against the forecast for a ship leaving hours after its first slice; a
+// negative value (the default) routes on the hour-0 weather alone. Timed queries always
+// expand the plain grid (JPS and HPA* tables hold one weather snapshot) and need a
+// forecast and a ship speed, otherwise they run untimed.
+void searchContextSetDeparture(SearchContext* ctx, float hours);
+// Returns 1 and fills out (caller frees with freePath) when a route exists.
+int astarSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out);
+// astarSearch on a process-wide context (not thread-safe).
+int astar(GridPos start, GridPos goal, RoutePath* out);
+void freePath(RoutePath* path);
+
+// --- Batch Routing ---
+// Queries run on a pool of threads sharing the read-only grids, one SearchContext per
+// worker kept between batches. Don't change the grids or weather during a batch.
+typedef struct {
+    GridPos start, goal;    // already on water (see snapToWater)
+    RoutePath path;         // filled in when found; caller frees with freePath
+    int found;
+} RouteQuery;
+typedef struct RoutePool RoutePool;
+// workers <= 0: parallelWorkers(). The calling thread is one of them.
+RoutePool* routePoolCreate(int workers);
+void routePoolFree(RoutePool* pool);
+int routePoolWorkers(const RoutePool* pool);
+// Gives every worker the open list, mode, heuristic and departure of like.
+void routePoolConfigure(RoutePool* pool, const SearchContext* like);
+// Routes every query and returns when all are done; the result is how many were found.
+int routePoolRun(RoutePool* pool, RouteQuery* queries, int count);
+
+// --- Smoothing ---
+// Pulls a finished route taut into waypoints (its first and last cell included): each
+// straight leg between them clears land and costs no more than the cells it replaces,
+// a leg costing a line raster along it walked as a grid path (octile length plus the
+// penalties of the cells it enters). out->cost is that of the legs, out->hours their
+// sailing time over the straight-line length. The masks it tests against
+// are built on the first call, so make that one before smoothing on several threads.
+// Returns the waypoint count; free out with freePath().
+int smoothPath(const RoutePath* path, RoutePath* out);
+
+// --- Distance Matrix ---
+// Cost (and sailing hours at serviceSpeed()) from every port to every other, one
+// search per source that stops once all ports are reached; sources run in parallel.
+// Ports must already be on water (see snapToWater). costs and hours (each NULL to skip)
+// are count*count, row = from, INFINITY where unreachable; paths (NULL to skip)
+// likewise, caller frees each with freePath. Returns the number of pairs reached.
+int distanceMatrix(const GridPos* ports, int count, float* costs, float* hours, RoutePath* paths);
+
+// --- Incremental Planner (D* Lite) ---
+// Keeps its search between calls: with the same goal, the next plannerRoute() repairs
+// only what changed since. Only two changes are repaired: a moved start, and cells whose
+// cost moved with the weather or a grid edit (found by comparing against costField). A
+// new goal or map wrap plans from scratch, and so does a weather change that would cost
+// the repair more than a new plan. Costs match an optimal (octile) astarSearch on the
+// hour-0 weather. One planner per thread.
+typedef struct Planner Planner;
+Planner* plannerCreate(void);
+void plannerFree(Planner* planner);
+int plannerRoute(Planner* planner, GridPos start, GridPos goal, RoutePath* out);
+// Watching and stopping a long plan: fn is called on the planning thread every few
+// thousand expansions with the count so far, and returning nonzero stops the search;
+// plannerRoute() then returns 0 and plannerStopped() 1. The next call with the same
+// goal carries on where it stopped. NULL removes the hook.
+typedef int (*PlannerProgress)(void* user, Planner* planner, int expanded);
+void plannerSetProgress(Planner* planner, PlannerProgress fn, void* user);
+int plannerStopped(const Planner* planner);
+// For use inside the hook. Up to max cells of the open queue, spread over it; returns
+// how many were written.
+int plannerFrontier(const Planner* planner, GridPos* out, int max);
+// The route from the cell expanded last to the goal (the search runs backward from
+// it), 0 if there is none yet. Free with freePath().
+int plannerPartialRoute(const Planner* planner, RoutePath* out);
+
+#endif
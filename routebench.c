@@ -0,0 +1,371 @@
+// Headless routing benchmark: routes a fixed corpus of A/B pairs (bench.txt) on the
+// bundled charts and checks each route's cost against the golden value stored with it,
+// so a change to the searches or the grid code is accepted or rejected on numbers.
+// Every chart is decoded and built from its PNG (no compiled grid is read or written),
+// then each weather section of the corpus is routed -r times on one thread with the
+// default search (astar(), binary heap, weighted Euclid); the fastest repeat counts.
+//
+// Corpus lines ('#' starts a comment):
+//   chart path.png [wrap] [water RRGGBB tolerance]   loads a chart (see setWaterColor)
+//   weather [lat lon radius peak_kts [core_radius]]  one storm for the pairs below it, in
+//                                                    the viewer's lat/lon; none: calm
+//   name xA yA xB yB [cost expanded]                 a pair in source-image pixels
+// A chart starts with the built-in storm. Cost -1 means no route is expected.
+//
+// -c adds correctness checks that are not timed: every pair of a section that follows a
+// weather change is planned with D* Lite on the weather before it and repaired on the
+// new one. The repair must cost what a fresh octile astarSearch() does and expand no
+// more cells than a new planner does from scratch (the planner searches backward from
+// the goal, so astarSearch()'s count is no yardstick for it). Before the first chart,
+// routes across an all-water grid must smooth to a single straight leg.
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "route.h"
+#include "perf.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define MAX_LINES 1024
+#define COST_TOLERANCE 1e-4f    // relative
+
+typedef enum { LINE_OTHER, LINE_CHART, LINE_WEATHER, LINE_PAIR } LineKind;
+
+typedef struct {
+    char text[256];             // the line as read, for -u
+    LineKind kind;
+    char name[48];
+    float xA, yA, xB, yB;
+    int hasGolden;
+    float goldenCost;
+    long long goldenExpanded;
+    // measured
+    int found;
+    float cost;
+    long long expanded;
+    double bestMs;
+} CorpusLine;
+
+static CorpusLine lines[MAX_LINES];
+static int lineCount = 0;
+// The storm set every chart starts from.
+static Storm builtIn[1];
+static float builtInAmbient;
+static int builtInCount;
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [-r repeats] [-u] [-c] [-P trace.csv] [corpus.txt]\n"
+        "  routes the corpus (default bench.txt) and checks every cost against its golden\n"
+        "  value; exits 1 if any differs\n"
+        "  -r routes each weather section this many times, keeping the fastest (default 3)\n"
+        "  -u writes the corpus to stdout with the measured costs as the new golden values\n"
+        "  -c also checks incremental replans after each weather change against fresh searches\n"
+        "     (same cost, no more expansions than planning from scratch),\n"
+        "     and that routes over open water smooth to one leg\n"
+        "  -P writes search counters and phase timings to a CSV trace\n", prog);
+}
+
+// Peak resident set of the process so far, in MB.
+static double peakRssMb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize / 1048576.0;
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_maxrss / 1024.0;     // kilobytes on Linux
+#endif
+}
+
+static int readCorpus(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    char buf[256];
+    while (lineCount < MAX_LINES && fgets(buf, sizeof(buf), f)) {
+        CorpusLine* l = &lines[lineCount++];
+        memset(l, 0, sizeof(*l));
+        buf[strcspn(buf, "\r\n")] = '\0';
+        snprintf(l->text, sizeof(l->text), "%s", buf);
+        char* hash = strchr(buf, '#'); if (hash) *hash = '\0';
+        char name[48];
+        float v[6];
+        int n = sscanf(buf, "%47s %f %f %f %f %f %f", name, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+        if (n >= 1 && !strcmp(name, "chart")) { l->kind = LINE_CHART; continue; }
+        if (n >= 1 && !strcmp(name, "weather")) { l->kind = LINE_WEATHER; continue; }
+        if (n < 5) continue;
+        l->kind = LINE_PAIR;
+        snprintf(l->name, sizeof(l->name), "%s", name);
+        l->xA = v[0]; l->yA = v[1]; l->xB = v[2]; l->yB = v[3];
+        l->hasGolden = n == 7;
+        l->goldenCost = v[4];
+        l->goldenExpanded = (long long)v[5];
+    }
+    fclose(f);
+    return 1;
+}
+
+// Decodes the chart and builds its grid under the options on the chart line.
+static int loadChart(const char* spec, FILE* report) {
+    char path[256] = "", word[32];
+    int offset = 0, wraps = 0;
+    unsigned water = 0x262626;
+    int tolerance = 0;
+    if (sscanf(spec, " chart %255s%n", path, &offset) != 1) return 0;
+    for (const char* p = spec + offset; sscanf(p, "%31s%n", word, &offset) == 1; p += offset) {
+        if (!strcmp(word, "wrap")) wraps = 1;
+        else if (!strcmp(word, "water")) {
+            int used = 0;
+            if (sscanf(p + offset, "%x %d%n", &water, &tolerance, &used) != 2) return 0;
+            offset += used;
+        }
+    }
+    setMapWraps(wraps);
+    setWaterColor(water, tolerance);
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    perfReset();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    SDL_Surface* tempSurf = IMG_Load(path);
+    if (!tempSurf) { fprintf(stderr, "cannot load %s: %s\n", path, IMG_GetError()); return 0; }
+    SDL_Surface* surf = SDL_ConvertSurfaceFormat(tempSurf, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(tempSurf);
+    if (!surf) { fprintf(stderr, "cannot convert %s: %s\n", path, SDL_GetError()); return 0; }
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    createCollisionGrid((const uint32_t*)surf->pixels, surf->w, surf->h);
+    SDL_FreeSurface(surf);
+    Uint64 t2 = SDL_GetPerformanceCounter();
+
+    PerfSnapshot perf;
+    perfSnapshot(&perf);
+    const PerfPhaseStats* ph = perf.phases;
+    fprintf(report, "%s: %dx%d -> grid %dx%d, startup %.1f ms (decode %.1f, grid %.1f: build %.1f, coast %.1f, wind %.1f, derived %.1f)\n",
+           path, mapWidth, mapHeight, gridW, gridH, (t2 - t0) * 1000.0 / freq, (t1 - t0) * 1000.0 / freq,
+           (t2 - t1) * 1000.0 / freq, ph[PERF_GRID_BUILD].lastMs, ph[PERF_COAST].lastMs, ph[PERF_WEATHER].lastMs,
+           ph[PERF_DERIVED].lastMs);
+    perfTraceRow("startup");
+    return 1;
+}
+
+// "weather" alone is calm; otherwise one storm. NULL: the built-in storm.
+static void applyWeather(const char* spec) {
+    float v[5];
+    int n = spec ? sscanf(spec, " weather %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4]) : 0;
+    if (!spec) setStorms(builtIn, builtInCount, builtInAmbient);
+    else if (n >= 4) {
+        Storm s = { v[0], v[1], v[2], n == 5 ? v[4] : v[2], v[3], 0.0f, 0.0f };
+        if (s.coreRadius > s.radius) s.coreRadius = s.radius;
+        setStorms(&s, 1, 5.0f);
+    } else setStorms(NULL, 0, 5.0f);
+    updateWeatherSimulation();
+}
+
+// Routes lines [first, last) repeats times and records the fastest run of each pair.
+static void routeSection(int first, int last, int repeats, SearchContext* ctx) {
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    for (int rep = 0; rep < repeats; rep++) {
+        for (int i = first; i < last; i++) {
+            CorpusLine* l = &lines[i];
+            if (l->kind != LINE_PAIR) continue;
+            float ax = l->xA - mapWidth/2.0f, ay = l->yA - mapHeight/2.0f;
+            float bx = l->xB - mapWidth/2.0f, by = l->yB - mapHeight/2.0f;
+            RoutePath path = { NULL, 0, 0, 0, 0 };
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            int found = snapToWater(&ax, &ay) && snapToWater(&bx, &by) &&
+                        astarSearch(ctx, worldToGrid(ax, ay), worldToGrid(bx, by), &path);
+            double ms = (SDL_GetPerformanceCounter() - t0) * 1000.0 / freq;
+            if (rep == 0 || ms < l->bestMs) l->bestMs = ms;
+            l->found = found;
+            l->cost = found ? path.cost : -1.0f;
+            l->expanded = path.expanded;
+            freePath(&path);
+        }
+    }
+}
+
+static int costMatches(const CorpusLine* l) {
+    if (l->goldenCost < 0 || !l->found) return l->goldenCost < 0 && !l->found;
+    return fabsf(l->cost - l->goldenCost) <= COST_TOLERANCE * l->goldenCost;
+}
+
+// Routes across a calm all-water grid and smooths them: with nothing in the way, each
+// must come out as one straight leg. Returns how many do not.
+static int checkSmoothing(SearchContext* ctx, FILE* report) {
+    static const GridPos ends[][2] = {
+        { { 10, 10 }, { 50, 50 } },         // a 45-degree run
+        { { 100, 100 }, { 120, 140 } },     // staircase then straight
+        { { 150, 20 }, { 20, 170 } },
+    };
+    int w = 192 * GRID_SCALE, h = 192 * GRID_SCALE, differ = 0;
+    uint32_t* sea = (uint32_t*)malloc(sizeof(uint32_t) * w * h);
+    if (!sea) return 1;
+    for (int i = 0; i < w * h; i++) sea[i] = 0xFF000000u | waterColor();
+    setMapWraps(0);
+    setStorms(NULL, 0, 5.0f);
+    createCollisionGrid(sea, w, h);
+    free(sea);
+    for (int i = 0; i < (int)(sizeof(ends) / sizeof(ends[0])); i++) {
+        RoutePath path = { NULL, 0, 0, 0, 0 }, taut = { NULL, 0, 0, 0, 0 };
+        int found = astarSearch(ctx, ends[i][0], ends[i][1], &path);
+        int waypoints = found ? smoothPath(&path, &taut) : 0;
+        if (waypoints != 2) differ++;
+        fprintf(report, "  smooth (%d,%d)->(%d,%d): %d cells, %d waypoints  %s\n", ends[i][0].r, ends[i][0].c,
+                ends[i][1].r, ends[i][1].c, path.len, waypoints, waypoints == 2 ? "ok" : "NOT TAUT");
+        freePath(&path); freePath(&taut);
+    }
+    return differ;
+}
+
+// Plans each pair of lines [first, last) on the weather before, repairs the plan on the
+// weather after (left in place) and compares its cost with a fresh octile search and its
+// expansions with a clean plan. Adds the pairs checked to *checked and returns how many
+// fail either.
+static int checkReplans(int first, int last, const char* before, const char* after, Planner* planner,
+                        SearchContext* octile, FILE* report, int* checked) {
+    int differ = 0;
+    for (int i = first; i < last; i++) {
+        const CorpusLine* l = &lines[i];
+        if (l->kind != LINE_PAIR) continue;
+        float ax = l->xA - mapWidth/2.0f, ay = l->yA - mapHeight/2.0f;
+        float bx = l->xB - mapWidth/2.0f, by = l->yB - mapHeight/2.0f;
+        if (!snapToWater(&ax, &ay) || !snapToWater(&bx, &by)) continue;
+        GridPos a = worldToGrid(ax, ay), b = worldToGrid(bx, by);
+        RoutePath old = { NULL, 0, 0, 0, 0 }, repaired = { NULL, 0, 0, 0, 0 }, fresh = { NULL, 0, 0, 0, 0 };
+        RoutePath scratch = { NULL, 0, 0, 0, 0 };
+        applyWeather(before);
+        plannerRoute(planner, a, b, &old);
+        applyWeather(after);
+        int found = plannerRoute(planner, a, b, &repaired);
+        int expected = astarSearch(octile, a, b, &fresh);
+        Planner* clean = plannerCreate();
+        plannerRoute(clean, a, b, &scratch);
+        plannerFree(clean);
+        (*checked)++;
+        int same = found == expected && (!found || fabsf(repaired.cost - fresh.cost) <= COST_TOLERANCE * fresh.cost);
+        int cheaper = repaired.expanded <= scratch.expanded;
+        if (!same || !cheaper) differ++;
+        fprintf(report, "  replan %-21s cost %10.3f fresh %10.3f  expanded %8d of %8d (octile %8d)  %s\n", l->name,
+                found ? repaired.cost : -1.0f, expected ? fresh.cost : -1.0f, repaired.expanded, scratch.expanded,
+                fresh.expanded, !same ? "REPLAN DIFFERS" : !cheaper ? "REPAIR DEARER" : "ok");
+        freePath(&old); freePath(&repaired); freePath(&fresh); freePath(&scratch);
+    }
+    return differ;
+}
+
+int main(int argc, char* argv[]) {
+    const char* corpusPath = "bench.txt";
+    const char* tracePath = NULL;
+    int repeats = 3, update = 0, check = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) repeats = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-u")) update = 1;
+        else if (!strcmp(argv[i], "-c")) check = 1;
+        else if (!strcmp(argv[i], "-P") && i + 1 < argc) tracePath = argv[++i];
+        else if (argv[i][0] == '-') { usage(argv[0]); return 2; }
+        else corpusPath = argv[i];
+    }
+    if (repeats < 1) { usage(argv[0]); return 2; }
+    if (!readCorpus(corpusPath)) { fprintf(stderr, "cannot read %s\n", corpusPath); return 2; }
+    if (tracePath && !perfTraceOpen(tracePath)) { fprintf(stderr, "cannot open %s\n", tracePath); return 2; }
+    IMG_Init(IMG_INIT_PNG);
+    // -u prints the corpus on stdout; the report goes to stderr instead.
+    FILE* report = update ? stderr : stdout;
+
+    builtInCount = currentStorms(builtIn, 1, &builtInAmbient);
+    SearchContext* ctx = searchContextCreate();
+    SearchContext* octile = NULL;
+    Planner* planner = NULL;
+    if (check) {
+        octile = searchContextCreate();
+        searchContextSetHeuristic(octile, HEURISTIC_OCTILE);
+        planner = plannerCreate();
+    }
+    // Weather lines in force before and after the last change; NULL: the built-in storm.
+    const char* before = NULL;
+    const char* weather = NULL;
+    int pairs = 0, checked = 0, failed = 0, chartOk = 0, replans = 0, replansFailed = 0, smoothFailed = 0;
+    if (check) smoothFailed = checkSmoothing(ctx, report);
+    for (int i = 0; i < lineCount; ) {
+        if (lines[i].kind == LINE_CHART) {
+            setStorms(builtIn, builtInCount, builtInAmbient);
+            chartOk = loadChart(lines[i].text, report);
+            before = weather = NULL;
+            i++;
+            continue;
+        }
+        if (lines[i].kind == LINE_WEATHER) {
+            if (chartOk) applyWeather(lines[i].text);
+            before = weather;
+            weather = lines[i].text;
+            i++;
+            continue;
+        }
+        if (lines[i].kind != LINE_PAIR) { i++; continue; }
+        // A section: the pairs up to the next chart or weather line.
+        int end = i;
+        while (end < lineCount && lines[end].kind != LINE_CHART && lines[end].kind != LINE_WEATHER) end++;
+        if (!chartOk) { fprintf(stderr, "pairs at line %d have no chart\n", i + 1); return 2; }
+        routeSection(i, end, repeats, ctx);
+        double ms = 0;
+        long long expanded = 0;
+        int count = 0;
+        for (int k = i; k < end; k++) {
+            CorpusLine* l = &lines[k];
+            if (l->kind != LINE_PAIR) continue;
+            count++;
+            ms += l->bestMs;
+            expanded += l->expanded;
+            const char* verdict = "new";
+            if (l->hasGolden) {
+                checked++;
+                if (costMatches(l)) verdict = "ok";
+                else { verdict = "COST DIFFERS"; failed++; }
+            }
+            char expDelta[32] = "";
+            if (l->hasGolden && l->goldenExpanded > 0)
+                snprintf(expDelta, sizeof(expDelta), " (%+.1f%%)", 100.0 * (l->expanded - l->goldenExpanded) / l->goldenExpanded);
+            fprintf(report, "  %-28s cost %10.3f golden %10.3f  expanded %8lld%s  %8.2f ms  %s\n", l->name, l->cost,
+                    l->hasGolden ? l->goldenCost : 0.0f, l->expanded, expDelta, l->bestMs, verdict);
+        }
+        pairs += count;
+        fprintf(report, "  %d routes in %.1f ms: %.1f routes/s, %.2fM expansions/s, peak RSS %.0f MB\n", count, ms,
+                ms > 0 ? count * 1000.0 / ms : 0.0, ms > 0 ? expanded / ms / 1000.0 : 0.0, peakRssMb());
+        perfTraceRow("routes");
+        if (check && weather) {
+            replansFailed += checkReplans(i, end, before, weather, planner, octile, report, &replans);
+        }
+        i = end;
+    }
+
+    if (update) {
+        for (int i = 0; i < lineCount; i++) {
+            const CorpusLine* l = &lines[i];
+            if (l->kind != LINE_PAIR) { printf("%s\n", l->text); continue; }
+            // Comments after the numbers are kept.
+            const char* comment = strchr(l->text, '#');
+            printf("%-28s %6.0f %6.0f %6.0f %6.0f %10.3f %9lld%s%s\n", l->name, l->xA, l->yA, l->xB, l->yB,
+                   l->found ? l->cost : -1.0f, l->expanded, comment ? "  " : "", comment ? comment : "");
+        }
+    }
+    fprintf(report, "%d routes, %d checked against golden costs, %d differ\n", pairs, checked, failed);
+    if (check) fprintf(report, "%d replans checked against fresh searches, %d failed; %d smoothing checks failed\n",
+                       replans, replansFailed, smoothFailed);
+
+    perfTraceClose();
+    plannerFree(planner);
+    searchContextFree(octile);
+    searchContextFree(ctx);
+    freeCollisionGrid();
+    IMG_Quit();
+    return failed || replansFailed || smoothFailed ? 1 : 0;
+}
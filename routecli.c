@@ -0,0 +1,445 @@
+// Headless batch router: loads the chart once, then routes every A/B pair it is given.
+// Input lines: "latA lonA latB lonB" (commas or whitespace, '#' starts a comment).
+// Lat/lon go through the viewer's own calibration, so coordinates read off the viewer round-trip;
+// -p takes source-image pixels "xA yA xB yB" instead and writes pixels back out.
+// -M takes a list of ports "lat lon [name]" instead and writes their cost/ETA matrix.
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "route.h"
+#include "parallel.h"
+#include "perf.h"
+
+typedef enum { OUT_CSV, OUT_GEOJSON } OutFormat;
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [-m map.png] [-g map.grid] [-c] [-G] [-n margin_nm] [-w storms.txt] [-f csv|geojson]\n"
+        "          [-o out] [-p] [-q binary|quad|radix] [-s astar|jps|hpa] [-e euclid|octile|alt]\n"
+        "          [-k landmarks] [-a table.alt] [-t depart_h] [-F steps,step_h] [-v kts]\n"
+        "          [-x forecast.wxc [-i source.csv|source.raw]] [-j threads] [-S] [-M ports.txt]\n"
+        "          [-P trace.csv] [pairs.txt|-]\n"
+        "  reads lat/lon A/B pairs from the file (or stdin) and writes one route per pair\n"
+        "  -M writes the cost and ETA matrix between every two ports in the file (one\n"
+        "     \"lat lon [name]\" per line) instead, with the routes as -f geojson\n"
+        "  -g compiled grid (default: map path with .grid), rebuilt when the map changes;\n"
+        "     -c only (re)compiles it and exits\n"
+        "  -G the chart is global: routes may cross its left/right edge (the antimeridian)\n"
+        "  -n pads water within this many nautical miles of land (default: one cell)\n"
+        "  -w replaces the built-in storm with the storms listed in the file\n"
+        "  -t routes against a forecast of drifting storms for a departure this many hours\n"
+        "     out, -F steps,step_h of it (default 16,6); -v ship speed (default: ship_info.txt)\n"
+        "  -x takes the weather from a forecast cube file (its first step, or all of it with\n"
+        "     -t) instead of the storms; -i only imports the CSV\n"
+        "     (hour,lat,lon,kts) or raw float32 (-F steps,step_h) source into it and exits\n"
+        "  -j routes on this many threads (default: one per CPU)\n"
+        "  -S writes each route as taut waypoints instead of one point per cell\n"
+        "  -q picks the open-list backend (default binary)\n"
+        "  -s picks the search (default astar), -e the heuristic (default weighted euclid)\n"
+        "  -e alt maps the landmark table (default: map path with .alt), building it with\n"
+        "     -k landmarks (default 8) when it is missing or stale\n"
+        "  -P writes search counters and phase timings to a CSV trace, a row per stage\n", prog);
+}
+
+// Same path with its extension replaced.
+static const char* siblingPath(const char* path, const char* ext, char* buf, int size) {
+    const char* dot = strrchr(path, '.');
+    int stem = dot ? (int)(dot - path) : (int)strlen(path);
+    snprintf(buf, size, "%.*s%s", stem, path, ext);
+    return buf;
+}
+
+// Maps the compiled grid when it matches the chart; otherwise decodes the chart with
+// SDL_image only (no video subsystem), builds the grid and compiles it for next time.
+static int loadMap(const char* path, const char* gridPath, int forceCompile) {
+    uint64_t sourceHash = hashFile(path);
+    if (!sourceHash) { fprintf(stderr, "cannot read %s\n", path); return 0; }
+    if (!forceCompile && loadCompiledGrid(gridPath, sourceHash)) return 1;
+    IMG_Init(IMG_INIT_PNG);
+    SDL_Surface* tempSurf = IMG_Load(path);
+    if (!tempSurf) { fprintf(stderr, "cannot load %s: %s\n", path, IMG_GetError()); return 0; }
+    SDL_Surface* surf = SDL_ConvertSurfaceFormat(tempSurf, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(tempSurf);
+    if (!surf) { fprintf(stderr, "cannot convert %s: %s\n", path, SDL_GetError()); return 0; }
+    createCollisionGrid((const uint32_t*)surf->pixels, surf->w, surf->h);
+    SDL_FreeSurface(surf);
+    if (saveCompiledGrid(gridPath, sourceHash)) fprintf(stderr, "compiled %s\n", gridPath);
+    else fprintf(stderr, "cannot write %s\n", gridPath);
+    return 1;
+}
+
+static int parsePair(char* line, float v[4]) {
+    char* hash = strchr(line, '#'); if (hash) *hash = '\0';
+    for (char* p = line; *p; p++) if (*p == ',' || *p == ';') *p = ' ';
+    return sscanf(line, "%f %f %f %f", &v[0], &v[1], &v[2], &v[3]) == 4;
+}
+
+static int pixelInput = 0;
+
+// Cell centre as (lon, lat), or (x, y) in source pixels with -p.
+static void cellCoord(GridPos p, float* x, float* y) {
+    *x = p.c * GRID_SCALE + GRID_SCALE/2.0f;
+    *y = p.r * GRID_SCALE + GRID_SCALE/2.0f;
+    if (!pixelInput) { *x = pixelToLon(*x); *y = pixelToLat(*y); }
+}
+
+// Reads "lat lon [name]" ports (x y with -p), snapped to water like route endpoints.
+// Returns the count; names default to the port's line number.
+static int readPorts(FILE* in, GridPos** ports, char (**names)[32]) {
+    char line[512];
+    int count = 0, capacity = 0;
+    *ports = NULL; *names = NULL;
+    while (fgets(line, sizeof(line), in)) {
+        char* hash = strchr(line, '#'); if (hash) *hash = '\0';
+        for (char* p = line; *p; p++) if (*p == ',' || *p == ';') *p = ' ';
+        float a, b;
+        char name[32] = "";
+        if (sscanf(line, "%f %f %31s", &a, &b, name) < 2) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            *ports = (GridPos*)realloc(*ports, sizeof(GridPos) * capacity);
+            *names = (char (*)[32])realloc(*names, sizeof(**names) * capacity);
+        }
+        float x = pixelInput ? a : lonToPixel(b), y = pixelInput ? b : latToPixel(a);
+        x -= mapWidth/2.0f; y -= mapHeight/2.0f;
+        (*ports)[count] = (GridPos){ -1, -1 };
+        if (snapToWater(&x, &y)) (*ports)[count] = worldToGrid(x, y);
+        else fprintf(stderr, "port %d: not near water\n", count);
+        if (name[0]) snprintf((*names)[count], 32, "%s", name);
+        else snprintf((*names)[count], 32, "%d", count);
+        count++;
+    }
+    return count;
+}
+
+static void writeMatrix(FILE* out, const char* label, const float* m, int count, char (*names)[32]) {
+    fprintf(out, "%s", label);
+    for (int j = 0; j < count; j++) fprintf(out, ",%s", names[j]);
+    fprintf(out, "\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%s", names[i]);
+        for (int j = 0; j < count; j++) {
+            float v = m[(size_t)i * count + j];
+            if (v < INFINITY) fprintf(out, ",%.3f", v); else fprintf(out, ",");
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Cell i of a path as cellCoord() gives it, with the columns unwrapped where the route
+// crosses the seam of a global chart, so lines stay continuous (x runs past the edge).
+static void pathCoord(const RoutePath* path, int i, int* shift, float* x, float* y) {
+    GridPos p = path->cells[i];
+    if (i > 0) {
+        int dc = p.c - path->cells[i - 1].c;
+        if (2 * dc > gridW) *shift -= gridW;
+        else if (-2 * dc > gridW) *shift += gridW;
+    }
+    p.c += *shift;
+    cellCoord(p, x, y);
+}
+
+static void writeRoute(FILE* out, OutFormat fmt, int id, const RoutePath* path, int* first) {
+    int shift = 0;
+    if (fmt == OUT_CSV) {
+        for (int i = 0; i < path->len; i++) {
+            float x, y; pathCoord(path, i, &shift, &x, &y);
+            fprintf(out, "%d,%d,%.5f,%.5f\n", id, i, y, x);
+        }
+        return;
+    }
+    fprintf(out, "%s\n{\"type\":\"Feature\",\"properties\":{\"id\":%d,\"cost\":%.3f,\"cells\":%d,\"hours\":%.2f},"
+                 "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[",
+            *first ? "" : ",", id, path->cost, path->len, path->hours);
+    for (int i = 0; i < path->len; i++) {
+        float x, y; pathCoord(path, i, &shift, &x, &y);
+        fprintf(out, "%s[%.5f,%.5f]", i ? "," : "", x, y);
+    }
+    fprintf(out, "]}}");
+    *first = 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* mapPath = "assets/temp1.png";
+    const char* gridPath = NULL;
+    int compileOnly = 0;
+    const char* inPath = "-";
+    const char* outPath = NULL;
+    OutFormat fmt = OUT_CSV;
+    OpenListKind openKind = OPEN_BINARY_HEAP;
+    SearchMode mode = SEARCH_ASTAR;
+    HeuristicKind heuristic = HEURISTIC_WEIGHTED_EUCLID;
+    const char* altPath = NULL;
+    int landmarks = 8;
+    float departure = -1.0f, stepHours = 6.0f, speed = 0.0f;
+    int steps = 16;
+    int workers = 0;
+    const char* cubePath = NULL;
+    const char* importPath = NULL;
+    const char* matrixPath = NULL;
+    const char* tracePath = NULL;
+    int smooth = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-m") && i + 1 < argc) mapPath = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) outPath = argv[++i];
+        else if (!strcmp(argv[i], "-g") && i + 1 < argc) gridPath = argv[++i];
+        else if (!strcmp(argv[i], "-c")) compileOnly = 1;
+        else if (!strcmp(argv[i], "-G")) setMapWraps(1);
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            const char* w = argv[++i];
+            if (loadStorms(w) < 0) { fprintf(stderr, "cannot read %s\n", w); return 1; }
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) setCoastalMargin((float)atof(argv[++i]));
+        else if (!strcmp(argv[i], "-p")) pixelInput = 1;
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            const char* f = argv[++i];
+            if (!strcmp(f, "csv")) fmt = OUT_CSV;
+            else if (!strcmp(f, "geojson")) fmt = OUT_GEOJSON;
+            else { usage(argv[0]); return 2; }
+        }
+        else if (!strcmp(argv[i], "-q") && i + 1 < argc) {
+            const char* q = argv[++i];
+            if (!strcmp(q, "binary")) openKind = OPEN_BINARY_HEAP;
+            else if (!strcmp(q, "quad")) openKind = OPEN_QUAD_HEAP;
+            else if (!strcmp(q, "radix")) openKind = OPEN_RADIX_HEAP;
+            else { usage(argv[0]); return 2; }
+        }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            const char* m = argv[++i];
+            if (!strcmp(m, "astar")) mode = SEARCH_ASTAR;
+            else if (!strcmp(m, "jps")) mode = SEARCH_JPS;
+            else if (!strcmp(m, "hpa")) mode = SEARCH_HPA;
+            else { usage(argv[0]); return 2; }
+        }
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+            const char* h = argv[++i];
+            if (!strcmp(h, "euclid")) heuristic = HEURISTIC_WEIGHTED_EUCLID;
+            else if (!strcmp(h, "octile")) heuristic = HEURISTIC_OCTILE;
+            else if (!strcmp(h, "alt")) heuristic = HEURISTIC_ALT;
+            else { usage(argv[0]); return 2; }
+        }
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) altPath = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) departure = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "-v") && i + 1 < argc) speed = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc) cubePath = argv[++i];
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) importPath = argv[++i];
+        else if (!strcmp(argv[i], "-M") && i + 1 < argc) matrixPath = argv[++i];
+        else if (!strcmp(argv[i], "-S")) smooth = 1;
+        else if (!strcmp(argv[i], "-P") && i + 1 < argc) tracePath = argv[++i];
+        else if (!strcmp(argv[i], "-F") && i + 1 < argc) {
+            char* f = argv[++i];
+            for (char* p = f; *p; p++) if (*p == ',' || *p == ':') *p = ' ';
+            if (sscanf(f, "%d %f", &steps, &stepHours) != 2 || steps < 1 || stepHours <= 0) { usage(argv[0]); return 2; }
+        }
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            landmarks = atoi(argv[++i]);
+            if (landmarks < 1 || landmarks > ALT_MAX_LANDMARKS) { usage(argv[0]); return 2; }
+        }
+        else if (argv[i][0] == '-' && argv[i][1]) { usage(argv[0]); return 2; }
+        else inPath = argv[i];
+    }
+
+    char defaultGrid[512], defaultAlt[512];
+    if (!gridPath) gridPath = siblingPath(mapPath, ".grid", defaultGrid, sizeof(defaultGrid));
+    if (tracePath && !perfTraceOpen(tracePath)) { fprintf(stderr, "cannot open %s\n", tracePath); return 1; }
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    if (!loadMap(mapPath, gridPath, compileOnly)) return 1;
+    Uint64 t1 = SDL_GetPerformanceCounter();
+    fprintf(stderr, "map %dx%d -> grid %dx%d in %.1f ms\n", mapWidth, mapHeight, gridW, gridH,
+            (t1 - t0) * 1000.0 / freq);
+    perfTraceRow("map");
+    if (compileOnly) { freeCollisionGrid(); IMG_Quit(); return 0; }
+    if (importPath) {
+        if (!cubePath) { usage(argv[0]); return 2; }
+        const char* ext = strrchr(importPath, '.');
+        int n = ext && !strcmp(ext, ".csv") ? importForecastCsv(importPath) : importForecastRaw(importPath, steps, stepHours);
+        if (n <= 0 || !saveForecast(cubePath)) { fprintf(stderr, "cannot import %s into %s\n", importPath, cubePath); return 1; }
+        fprintf(stderr, "imported %d x %.1f h steps into %s\n", n, forecastStepHours(), cubePath);
+        freeCollisionGrid(); IMG_Quit(); return 0;
+    }
+
+    if (matrixPath) inPath = matrixPath;
+    FILE* in = strcmp(inPath, "-") ? fopen(inPath, "r") : stdin;
+    if (!in) { fprintf(stderr, "cannot open %s\n", inPath); return 1; }
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) { fprintf(stderr, "cannot open %s\n", outPath); return 1; }
+
+    if (heuristic == HEURISTIC_ALT) {
+        if (!altPath) altPath = siblingPath(mapPath, ".alt", defaultAlt, sizeof(defaultAlt));
+        Uint64 a0 = SDL_GetPerformanceCounter();
+        if (loadLandmarks(altPath) && landmarkCount() == landmarks)
+            fprintf(stderr, "mapped %d landmarks from %s\n", landmarkCount(), altPath);
+        else if (buildLandmarks(landmarks, altPath))
+            fprintf(stderr, "built %d landmarks into %s in %.1f ms\n", landmarkCount(), altPath,
+                    (SDL_GetPerformanceCounter() - a0) * 1000.0 / freq);
+        else fprintf(stderr, "no landmarks, falling back to octile\n");
+        perfTraceRow("landmarks");
+    }
+    if (speed > 0) setServiceSpeed(speed);
+    else loadShipSpeed("ship_info.txt");
+    if (departure >= 0 && serviceSpeed() <= 0) { fprintf(stderr, "-t needs a ship speed (-v or ship_info.txt)\n"); return 1; }
+    if (departure >= 0 || cubePath) {
+        Uint64 f0 = SDL_GetPerformanceCounter();
+        if (cubePath && !loadForecast(cubePath)) { fprintf(stderr, "cannot load forecast %s\n", cubePath); return 1; }
+        if (!cubePath) buildForecast(steps, stepHours);
+        fprintf(stderr, "forecast %d x %.1f h at %.1f kts in %.1f ms\n", forecastSteps(), forecastStepHours(), serviceSpeed(),
+                (SDL_GetPerformanceCounter() - f0) * 1000.0 / freq);
+        perfTraceRow("forecast");
+    }
+    if (mode != SEARCH_ASTAR && departure < 0) {
+        Uint64 p0 = SDL_GetPerformanceCounter();
+        prepareSearch(mode);
+        fprintf(stderr, "%s tables in %.1f ms\n", mode == SEARCH_JPS ? "jump" : "cluster",
+                (SDL_GetPerformanceCounter() - p0) * 1000.0 / freq);
+        perfTraceRow("tables");
+    }
+
+    if (matrixPath) {
+        // Costs are untimed: the matrix is against the current weather, not a departure.
+        GridPos* ports;
+        char (*names)[32];
+        int count = readPorts(in, &ports, &names);
+        size_t pairs = (size_t)count * count;
+        float* costs = (float*)malloc(sizeof(float) * (pairs ? pairs : 1));
+        float* hours = (float*)malloc(sizeof(float) * (pairs ? pairs : 1));
+        RoutePath* paths = fmt == OUT_GEOJSON ? (RoutePath*)calloc(pairs ? pairs : 1, sizeof(RoutePath)) : NULL;
+        if (workers > 0) setParallelWorkers(workers);
+        Uint64 s0 = SDL_GetPerformanceCounter();
+        int reached = distanceMatrix(ports, count, costs, hours, paths);
+        double secs = (SDL_GetPerformanceCounter() - s0) / (double)freq;
+        perfTraceRow("matrix");
+        if (fmt == OUT_CSV) {
+            writeMatrix(out, "cost", costs, count, names);
+            if (serviceSpeed() > 0) { fprintf(out, "\n"); writeMatrix(out, "hours", hours, count, names); }
+        } else {
+            int first = 1;
+            fprintf(out, "{\"type\":\"FeatureCollection\",\"features\":[");
+            for (int i = 0; i < count; i++)
+                for (int j = 0; j < count; j++) {
+                    RoutePath* p = &paths[(size_t)i * count + j];
+                    if (i == j || !p->cells) { freePath(p); continue; }
+                    if (smooth) {
+                        RoutePath taut;
+                        smoothPath(p, &taut);
+                        freePath(p);
+                        *p = taut;
+                    }
+                    fprintf(out, "%s\n{\"type\":\"Feature\",\"properties\":{\"from\":\"%s\",\"to\":\"%s\",\"cost\":%.3f,\"hours\":%.2f},"
+                                 "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[",
+                            first ? "" : ",", names[i], names[j], p->cost, p->hours);
+                    int shift = 0;
+                    for (int k = 0; k < p->len; k++) {
+                        float x, y; pathCoord(p, k, &shift, &x, &y);
+                        fprintf(out, "%s[%.5f,%.5f]", k ? "," : "", x, y);
+                    }
+                    fprintf(out, "]}}");
+                    first = 0;
+                    freePath(p);
+                }
+            fprintf(out, "\n]}\n");
+        }
+        fprintf(stderr, "%d ports, %d of %zu pairs reached, %.3f s on %d threads\n",
+                count, reached, pairs, secs, parallelWorkers());
+        free(ports); free(names); free(costs); free(hours); free(paths);
+        if (in != stdin) fclose(in);
+        if (out != stdout) fclose(out);
+        perfTraceClose();
+        freeCollisionGrid();
+        IMG_Quit();
+        return 0;
+    }
+
+    if (fmt == OUT_CSV) fprintf(out, pixelInput ? "id,seq,y,x\n" : "id,seq,lat,lon\n");
+    else fprintf(out, "{\"type\":\"FeatureCollection\",\"features\":[");
+
+    SearchContext* ctx = searchContextCreate();
+    searchContextSetOpenList(ctx, openKind);
+    searchContextSetMode(ctx, mode);
+    searchContextSetHeuristic(ctx, heuristic);
+    searchContextSetDeparture(ctx, departure);
+    RoutePool* pool = routePoolCreate(workers);
+    routePoolConfigure(pool, ctx);
+
+    // Every pair is read and snapped first, then the batch is routed on the pool.
+    char line[512];
+    RouteQuery* queries = NULL;
+    int count = 0, capacity = 0;
+    while (fgets(line, sizeof(line), in)) {
+        float v[4];
+        if (!parsePair(line, v)) continue;
+        if (!pixelInput) {
+            float latA = v[0], lonA = v[1], latB = v[2], lonB = v[3];
+            v[0] = lonToPixel(lonA); v[1] = latToPixel(latA);
+            v[2] = lonToPixel(lonB); v[3] = latToPixel(latB);
+        }
+        float ax = v[0] - mapWidth/2.0f, ay = v[1] - mapHeight/2.0f;
+        float bx = v[2] - mapWidth/2.0f, by = v[3] - mapHeight/2.0f;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            queries = (RouteQuery*)realloc(queries, sizeof(RouteQuery) * capacity);
+        }
+        RouteQuery* q = &queries[count++];
+        memset(q, 0, sizeof(*q));
+        q->start = q->goal = (GridPos){ -1, -1 };     // unsnappable: fails like a blocked route
+        if (snapToWater(&ax, &ay) && snapToWater(&bx, &by)) { q->start = worldToGrid(ax, ay); q->goal = worldToGrid(bx, by); }
+    }
+
+    Uint64 s0 = SDL_GetPerformanceCounter();
+    int routed = routePoolRun(pool, queries, count), first = 1;
+    Uint64 searchTicks = SDL_GetPerformanceCounter() - s0;
+    perfTraceRow("search");
+    long long expanded = 0, cells = 0, waypoints = 0;
+    Uint64 smoothTicks = 0;
+    for (int id = 0; id < count; id++) {
+        RouteQuery* q = &queries[id];
+        if (!q->found) { fprintf(stderr, "route %d: no route possible\n", id); continue; }
+        expanded += q->path.expanded;
+        if (smooth) {
+            RoutePath taut;
+            Uint64 m0 = SDL_GetPerformanceCounter();
+            smoothPath(&q->path, &taut);
+            smoothTicks += SDL_GetPerformanceCounter() - m0;
+            cells += q->path.len;
+            waypoints += taut.len;
+            freePath(&q->path);
+            q->path = taut;
+        }
+        writeRoute(out, fmt, id, &q->path, &first);
+        freePath(&q->path);
+    }
+
+    if (fmt == OUT_GEOJSON) fprintf(out, "\n]}\n");
+    double secs = searchTicks / (double)freq;
+    fprintf(stderr, "%d routes, %d failed, %.3f s searching on %d threads, %.1f routes/s, %.2fM expansions/s\n",
+            routed, count - routed, secs, routePoolWorkers(pool), secs > 0 ? count / secs : 0.0,
+            secs > 0 ? expanded / secs / 1e6 : 0.0);
+    if (smooth)
+        fprintf(stderr, "smoothed %lld cells to %lld waypoints in %.1f ms (%.1f%% of search)\n", cells, waypoints,
+                smoothTicks * 1000.0 / freq, searchTicks ? 100.0 * smoothTicks / searchTicks : 0.0);
+    if (tracePath) {
+        PerfSnapshot perf;
+        perfSnapshot(&perf);
+        fprintf(stderr, "%lld pushes, %lld pops (%lld stale), open list peak %lld, %.1f ms in searches\n",
+                perf.counters[PERF_PUSHES], perf.counters[PERF_POPS], perf.counters[PERF_STALE_POPS],
+                perf.counters[PERF_PEAK_OPEN], perf.counters[PERF_SEARCH_US] / 1000.0);
+        perfTraceRow(smooth ? "smooth" : "done");
+        perfTraceClose();
+    }
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    free(queries);
+    routePoolFree(pool);
+    searchContextFree(ctx);
+    freeCollisionGrid();
+    IMG_Quit();
+    return 0;
+}
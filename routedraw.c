@@ -0,0 +1,157 @@
+#include "routedraw.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Level k is Douglas-Peucker at BASE_TOLERANCE * 2^k map pixels applied to level k-1, so
+// it strays at most twice that from the route. Each level is cut into runs of
+// RUN_SEGMENTS segments that share their end points; a run is drawn only if its box
+// meets the screen, and consecutive visible runs go out as one polyline.
+
+#define DRAW_LEVELS 8
+#define BASE_TOLERANCE 0.25f
+#define RUN_SEGMENTS 32
+
+typedef struct { float minX, minY, maxX, maxY; } Bounds;
+
+typedef struct {
+    SDL_FPoint* points;
+    int count;
+    Bounds* runs;           // run i covers points i * RUN_SEGMENTS .. + RUN_SEGMENTS
+    int runCount;
+} DrawLevel;
+
+struct RouteDraw {
+    SDL_Renderer* ren;
+    DrawLevel levels[DRAW_LEVELS];
+    Bounds bounds;
+    SDL_Point* scratch;
+    int scratchCap;
+};
+
+RouteDraw* routeDrawCreate(SDL_Renderer* ren) {
+    RouteDraw* rd = (RouteDraw*)calloc(1, sizeof(RouteDraw));
+    if (rd) rd->ren = ren;
+    return rd;
+}
+
+static void clearLevels(RouteDraw* rd) {
+    for (int k = 0; k < DRAW_LEVELS; k++) {
+        free(rd->levels[k].points);
+        free(rd->levels[k].runs);
+        memset(&rd->levels[k], 0, sizeof(DrawLevel));
+    }
+}
+
+void routeDrawFree(RouteDraw* rd) {
+    if (!rd) return;
+    clearLevels(rd);
+    free(rd->scratch);
+    free(rd);
+}
+
+static float segmentDistance2(SDL_FPoint p, SDL_FPoint a, SDL_FPoint b) {
+    float dx = b.x - a.x, dy = b.y - a.y, len2 = dx * dx + dy * dy;
+    float t = len2 > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0;
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+    float ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+    return ex * ex + ey * ey;
+}
+
+// Douglas-Peucker over src, which is already the previous (finer) level: keep[] marks
+// the points to retain. Ranges still to split wait on an explicit stack.
+static int simplify(const SDL_FPoint* src, int n, float tolerance, SDL_FPoint* out) {
+    if (n <= 2) { memcpy(out, src, sizeof(SDL_FPoint) * n); return n; }
+    unsigned char* keep = (unsigned char*)calloc(n, 1);
+    int* stack = (int*)malloc(sizeof(int) * 2 * n);
+    float tol2 = tolerance * tolerance;
+    int top = 0;
+    keep[0] = keep[n - 1] = 1;
+    stack[top++] = 0; stack[top++] = n - 1;
+    while (top > 0) {
+        int b = stack[--top], a = stack[--top];
+        float worst = -1;
+        int split = -1;
+        for (int i = a + 1; i < b; i++) {
+            float d = segmentDistance2(src[i], src[a], src[b]);
+            if (d > worst) { worst = d; split = i; }
+        }
+        if (split < 0 || worst <= tol2) continue;
+        keep[split] = 1;
+        stack[top++] = a; stack[top++] = split;
+        stack[top++] = split; stack[top++] = b;
+    }
+    int m = 0;
+    for (int i = 0; i < n; i++) if (keep[i]) out[m++] = src[i];
+    free(keep); free(stack);
+    return m;
+}
+
+static Bounds boundsOf(const SDL_FPoint* p, int n) {
+    Bounds b = { p[0].x, p[0].y, p[0].x, p[0].y };
+    for (int i = 1; i < n; i++) {
+        if (p[i].x < b.minX) b.minX = p[i].x;
+        if (p[i].x > b.maxX) b.maxX = p[i].x;
+        if (p[i].y < b.minY) b.minY = p[i].y;
+        if (p[i].y > b.maxY) b.maxY = p[i].y;
+    }
+    return b;
+}
+
+void routeDrawSet(RouteDraw* rd, const SDL_FPoint* points, int count) {
+    clearLevels(rd);
+    if (!points || count < 2) return;
+    const SDL_FPoint* src = points;
+    int n = count;
+    for (int k = 0; k < DRAW_LEVELS; k++) {
+        DrawLevel* level = &rd->levels[k];
+        level->points = (SDL_FPoint*)malloc(sizeof(SDL_FPoint) * n);
+        level->count = simplify(src, n, BASE_TOLERANCE * (float)(1 << k), level->points);
+        level->runCount = (level->count - 2) / RUN_SEGMENTS + 1;
+        level->runs = (Bounds*)malloc(sizeof(Bounds) * level->runCount);
+        for (int i = 0; i < level->runCount; i++) {
+            int first = i * RUN_SEGMENTS, last = first + RUN_SEGMENTS;
+            if (last > level->count - 1) last = level->count - 1;
+            level->runs[i] = boundsOf(level->points + first, last - first + 1);
+        }
+        src = level->points;
+        n = level->count;
+    }
+    rd->bounds = boundsOf(points, count);
+    if (rd->scratchCap < count) {
+        rd->scratch = (SDL_Point*)realloc(rd->scratch, sizeof(SDL_Point) * count);
+        rd->scratchCap = count;
+    }
+}
+
+int routeDrawRender(RouteDraw* rd, float originX, float originY, float zoom) {
+    if (!rd || !rd->levels[0].count || zoom <= 0) return 0;
+    int screenW, screenH;
+    if (SDL_GetRendererOutputSize(rd->ren, &screenW, &screenH) != 0) return 0;
+    // The screen in world space, a pixel wider all round.
+    Bounds view = { (-1 - originX) / zoom, (-1 - originY) / zoom, (screenW + 1 - originX) / zoom, (screenH + 1 - originY) / zoom };
+    const Bounds* all = &rd->bounds;
+    if (all->maxX < view.minX || all->minX > view.maxX || all->maxY < view.minY || all->minY > view.maxY) return 0;
+
+    int k = 0;
+    while (k + 1 < DRAW_LEVELS && BASE_TOLERANCE * (float)(1 << (k + 1)) * zoom <= 0.5f) k++;
+    const DrawLevel* level = &rd->levels[k];
+    int submitted = 0, len = 0;
+    for (int i = 0; i <= level->runCount; i++) {
+        const Bounds* b = i < level->runCount ? &level->runs[i] : NULL;
+        int visible = b && !(b->maxX < view.minX || b->minX > view.maxX || b->maxY < view.minY || b->minY > view.maxY);
+        if (!visible) {
+            if (len > 1) { SDL_RenderDrawLines(rd->ren, rd->scratch, len); submitted += len; }
+            len = 0;
+            continue;
+        }
+        int first = i * RUN_SEGMENTS, last = first + RUN_SEGMENTS;
+        if (last > level->count - 1) last = level->count - 1;
+        // A run continuing the open polyline shares its first point with the last run.
+        for (int p = len > 0 ? first + 1 : first; p <= last; p++) {
+            SDL_Point s = { (int)(originX + level->points[p].x * zoom), (int)(originY + level->points[p].y * zoom) };
+            if (len > 0 && s.x == rd->scratch[len - 1].x && s.y == rd->scratch[len - 1].y) continue;
+            rd->scratch[len++] = s;
+        }
+    }
+    return submitted;
+}
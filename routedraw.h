@@ -0,0 +1,23 @@
+#ifndef ROUTEDRAW_H
+#define ROUTEDRAW_H
+
+// Route drawing for the viewers (storm.c, storm2.c). The polyline is kept in world
+// space, simplified once per zoom level when it is set (Douglas-Peucker, tolerances
+// doubling from a quarter of a map pixel), and split into runs of points with bounding
+// boxes. A frame draws the coarsest level that stays within a screen pixel of the
+// route, skips the runs off screen and hands the rest to SDL_RenderDrawLines, so the cost
+// follows what is visible at that zoom rather than the route's length.
+#include <SDL2/SDL.h>
+
+typedef struct RouteDraw RouteDraw;
+
+RouteDraw* routeDrawCreate(SDL_Renderer* ren);
+void routeDrawFree(RouteDraw* rd);
+// Replaces the route with count world-space points (count 0 clears it). On a wrapped
+// chart pass x unwrapped, continuing past the edge, and draw the neighbouring copies.
+void routeDrawSet(RouteDraw* rd, const SDL_FPoint* points, int count);
+// Draws in the current draw colour, a world point landing at origin + point * zoom.
+// Returns the points submitted.
+int routeDrawRender(RouteDraw* rd, float originX, float originY, float zoom);
+
+#endif
@@ -0,0 +1,167 @@
+#include "searchctx.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// Batch routing on a persistent pool of worker threads. The grids and the tables
+// derived from them are only read during a batch; each worker owns a SearchContext,
+// kept between batches so its scratch is allocated once.
+// A batch starts out split into one contiguous range of queries per worker. A worker
+// takes queries from the front of its own range; once that is empty it steals the
+// back half of the first range it finds with work left, so a few long ocean crossings
+// don't leave the other workers idle. A range is a (begin, end) pair packed into one
+// atomic word, so taking and stealing are a single compare-and-swap each.
+
+#define POOL_MAX_WORKERS 64
+
+typedef struct { RoutePool* pool; int worker; } PoolWorker;
+
+struct RoutePool {
+    int workers;
+    pthread_t threads[POOL_MAX_WORKERS];
+    PoolWorker args[POOL_MAX_WORKERS];
+    SearchContext* ctx[POOL_MAX_WORKERS];
+    _Atomic uint64_t range[POOL_MAX_WORKERS];     // begin << 32 | end
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done;
+    unsigned batch;         // bumped to start a batch
+    int running;            // helpers still working on the current batch
+    int stop;
+    RouteQuery* queries;
+    atomic_int found;
+};
+
+static int takeOwn(_Atomic uint64_t* range, int* idx) {
+    uint64_t v = atomic_load(range);
+    for (;;) {
+        uint32_t begin = (uint32_t)(v >> 32), end = (uint32_t)v;
+        if (begin >= end) return 0;
+        if (atomic_compare_exchange_weak(range, &v, ((uint64_t)(begin + 1) << 32) | end)) { *idx = (int)begin; return 1; }
+    }
+}
+
+// Moves the back half of another worker's range into this (empty) one.
+static int steal(RoutePool* pool, int self) {
+    for (int k = 1; k < pool->workers; k++) {
+        _Atomic uint64_t* victim = &pool->range[(self + k) % pool->workers];
+        uint64_t v = atomic_load(victim);
+        for (;;) {
+            uint32_t begin = (uint32_t)(v >> 32), end = (uint32_t)v;
+            if (begin >= end) break;
+            uint32_t mid = end - (end - begin + 1) / 2;
+            if (atomic_compare_exchange_weak(victim, &v, ((uint64_t)begin << 32) | mid)) {
+                atomic_store(&pool->range[self], ((uint64_t)mid << 32) | end);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void runQueries(RoutePool* pool, int self) {
+    SearchContext* ctx = pool->ctx[self];
+    int found = 0, idx;
+    do {
+        while (takeOwn(&pool->range[self], &idx)) {
+            RouteQuery* q = &pool->queries[idx];
+            q->found = astarSearch(ctx, q->start, q->goal, &q->path);
+            found += q->found;
+        }
+    } while (steal(pool, self));
+    atomic_fetch_add(&pool->found, found);
+}
+
+static void* workerMain(void* arg) {
+    PoolWorker* w = (PoolWorker*)arg;
+    RoutePool* pool = w->pool;
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->batch == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stop) break;
+        seen = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+        runQueries(pool, w->worker);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+RoutePool* routePoolCreate(int workers) {
+    if (workers <= 0) workers = parallelWorkers();
+    if (workers > POOL_MAX_WORKERS) workers = POOL_MAX_WORKERS;
+    RoutePool* pool = (RoutePool*)calloc(1, sizeof(RoutePool));
+    if (!pool) return NULL;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->ctx[0] = searchContextCreate();
+    pool->workers = 1;
+    // The calling thread is worker 0; a helper that fails to start is simply not counted.
+    for (int w = 1; w < workers; w++) {
+        int slot = pool->workers;
+        pool->ctx[slot] = searchContextCreate();
+        pool->args[slot].pool = pool;
+        pool->args[slot].worker = slot;
+        if (pthread_create(&pool->threads[slot], NULL, workerMain, &pool->args[slot]) != 0) {
+            searchContextFree(pool->ctx[slot]);
+            break;
+        }
+        pool->workers++;
+    }
+    return pool;
+}
+
+void routePoolFree(RoutePool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int w = 1; w < pool->workers; w++) pthread_join(pool->threads[w], NULL);
+    for (int w = 0; w < pool->workers; w++) searchContextFree(pool->ctx[w]);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
+}
+
+int routePoolWorkers(const RoutePool* pool) { return pool->workers; }
+
+void routePoolConfigure(RoutePool* pool, const SearchContext* like) {
+    for (int w = 0; w < pool->workers; w++) {
+        SearchContext* ctx = pool->ctx[w];
+        ctx->openKind = like->openKind;
+        ctx->mode = like->mode;
+        ctx->heuristic = like->heuristic;
+        ctx->departure = like->departure;
+    }
+}
+
+int routePoolRun(RoutePool* pool, RouteQuery* queries, int count) {
+    if (count <= 0) return 0;
+    // Tables a search mode would otherwise build on its first query, i.e. inside a worker.
+    prepareSearch(pool->ctx[0]->mode);
+    pool->queries = queries;
+    atomic_store(&pool->found, 0);
+    for (int w = 0; w < pool->workers; w++) {
+        uint32_t begin = (uint32_t)((long long)count * w / pool->workers);
+        uint32_t end = (uint32_t)((long long)count * (w + 1) / pool->workers);
+        atomic_store(&pool->range[w], ((uint64_t)begin << 32) | end);
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->running = pool->workers - 1;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    runQueries(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    return atomic_load(&pool->found);
+}
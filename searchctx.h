@@ -0,0 +1,149 @@
+#ifndef SEARCHCTX_H
+#define SEARCHCTX_H
+
+// Internals shared by the grid searches (route.c, jps.c, hpa.c, alt.c). Not part of the public API.
+#include "route.h"
+#include "openlist.h"
+#include <math.h>
+#include <stddef.h>
+
+#define STEP_STRAIGHT 1.0f
+#define STEP_DIAGONAL 1.414f
+#define COST_SCALE 32.0f        // costField units per step
+#define COST_LAND 0xFFFF
+
+// Scratch space kept alive between queries, one array per field (12 bytes a cell).
+// g/parent are only meaningful when stamp[idx] == generation, so starting a query is
+// a counter bump instead of a pass over the whole grid. h is recomputed on demand.
+struct SearchContext {
+    int cells;
+    float* g;
+    int32_t* parent;       // cell index, -1 at the start
+    uint32_t* stamp;
+    uint32_t generation;
+    OpenListKind openKind;
+    OpenList openList;
+    SearchMode mode;
+    HeuristicKind heuristic;
+    struct HpaScratch* hpa;    // abstract-graph buffers, created on the first HPA query
+    // HEURISTIC_ALT: the goal's landmark distances, fetched once per query
+    int altReady;
+    // Column period for the heuristic: gridW on a wrapping chart, else too large to matter.
+    int wrapW;
+    float altGoalPenalty;
+    uint16_t altGoal[ALT_MAX_LANDMARKS];
+    // Timed queries: departure hour (< 0 when untimed) and the arrival hour of each
+    // cell's current best path, valid under the same stamp as g.
+    float departure;
+    float* arrival;
+};
+
+// Everything a cell charges on top of the base step (padding, storm), fixed point in
+// 1/COST_SCALE, or COST_LAND. Rebuilt from collisionGrid and weatherGrid on every
+// refreshDerivedGrids(), so neighbour loops do one 2-byte load per cell.
+extern uint16_t* costField;
+void updateCostField(void);
+// The costField entry for a cell of the given type (0/1/2) under wind kts.
+uint16_t cellCost(unsigned char cell, float wind);
+// Wind field at hours after the current weather, into gridW*gridH floats (weather.c).
+void computeWind(float* out, float hours);
+
+// setMapWraps(): column -1 is column gridW - 1 and column gridW is column 0.
+extern int wrapColumns;
+
+// Column of a one-step move to c (-1 <= c <= gridW); -1 off the edge of the chart.
+static inline int stepColumn(int c) {
+    if ((unsigned)c < (unsigned)gridW) return c;
+    return wrapColumns ? (c < 0 ? c + gridW : c - gridW) : -1;
+}
+
+// Columns between a and b, the short way round on a wrapping chart.
+static inline int columnGap(int a, int b) {
+    int d = a > b ? a - b : b - a;
+    return wrapColumns && gridW - d < d ? gridW - d : d;
+}
+
+// 8-neighbourhood in the plain expansion order, with the step of each move.
+extern const int neighbourDr[8];
+extern const int neighbourDc[8];
+extern const float neighbourStep[8];
+
+// 1 where a cell and its 8 neighbours all cost the base step (or are land/off-grid).
+extern unsigned char* jumpMask;
+extern int16_t* jumpDist;
+// Landmark distance tables (alt.c), cell-major: altDist[idx * altCount + l].
+extern const uint16_t* altDist;
+extern int altCount;
+extern float altScale;
+
+// Sizes the buffers for the current grid and opens a new generation.
+void beginSearch(SearchContext* ctx);
+// Walks parent indices back from idx and stores the cells start-first. Consecutive
+// entries may be several cells apart (jump points); the gap is filled in as a diagonal
+// run followed by a straight run, so the result has one entry per cell.
+void buildPath(const int32_t* parent, int idx, RoutePath* out);
+void updateJumpMask(void);
+// Plain 8-neighbour A*; astarSearch() has already checked the endpoints.
+int astarGridSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out);
+int jpsSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out);
+int hpaSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out);
+// Sailing time along a finished path at serviceSpeed().
+float routeHours(const RoutePath* path);
+// Plain A* charging each cell from the forecast slice of its arrival time (forecast.c).
+int timedSearch(SearchContext* ctx, GridPos start, GridPos goal, RoutePath* out);
+// The forecast is dropped with the grid.
+void freeForecast(void);
+void hpaScratchFree(struct HpaScratch* s);
+// Bit masks behind smoothPath() (smooth.c): rebuilt if they exist, dropped with the grid.
+void refreshSightMasks(void);
+void freeSightMasks(void);
+// Unmaps a grid that loadCompiledGrid() pointed collisionGrid into; 0 if it was not mapped.
+int releaseCompiledGrid(void);
+// Turns water within the coastal margin into padding (2). Needs land marked as 1.
+void markCoastalPadding(void);
+int hierarchyBuilt(void);
+// Caches what the heuristic needs about the goal. Call after beginSearch().
+void beginHeuristic(SearchContext* ctx, int goalIdx);
+
+// Wind-free part of the cost of entering idx beyond the base step; what the landmark
+// tables were computed with.
+static inline float landmarkPenalty(int idx) {
+    return collisionGrid[idx] == 2 ? PADDING_COST : 0.0f;
+}
+
+// Best landmark bound on the cost from idx to the goal, never below floor. Stored
+// values are rounded down, hence the -1 on each difference. Distances are one-way
+// (cost is charged on the cell entered): the first term is the triangle inequality
+// through d(L, .); the second uses that reversing a path only swaps which end pays
+// its padding.
+static inline float landmarkBound(const SearchContext* ctx, int idx, float floor) {
+    const uint16_t* d = altDist + (size_t)idx * altCount;
+    float penalty = landmarkPenalty(idx) * altScale;
+    float best = 0;
+    for (int l = 0; l < altCount; l++) {
+        int t = ctx->altGoal[l], v = d[l];
+        if (t == 0xFFFF || v == 0xFFFF) continue;
+        if (v < 0xFFFE && t - v - 1 > best) best = (float)(t - v - 1);
+        if (t < 0xFFFE && v - t - 1 - penalty + ctx->altGoalPenalty > best) best = v - t - 1 - penalty + ctx->altGoalPenalty;
+    }
+    best /= altScale;
+    return best > floor ? best : floor;
+}
+
+static inline float heuristic(const SearchContext* ctx, int r, int c, int endR, int endC) {
+    int dr = r > endR ? r - endR : endR - r;
+    int dc = c > endC ? c - endC : endC - c;
+    dc = ctx->wrapW - dc < dc ? ctx->wrapW - dc : dc;
+    if (ctx->heuristic == HEURISTIC_OCTILE || ctx->heuristic == HEURISTIC_ALT) {
+        float octile = dr > dc ? (dr - dc) + STEP_DIAGONAL * dc : (dc - dr) + STEP_DIAGONAL * dr;
+        return ctx->altReady ? landmarkBound(ctx, r * gridW + c, octile) : octile;
+    }
+    return sqrtf((float)(dr * dr + dc * dc)) * 1.2f;
+}
+
+// Cost of stepping into cell idx: base step, coastal padding and storm penalty.
+static inline float enterCost(int idx, int diagonal) {
+    return (diagonal ? STEP_DIAGONAL : STEP_STRAIGHT) + costField[idx] * (1.0f / COST_SCALE);
+}
+
+#endif
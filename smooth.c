@@ -0,0 +1,167 @@
+#include "searchctx.h"
+#include <stdlib.h>
+#include <string.h>
+
+// String pulling over a finished route. From each waypoint the route is followed as
+// far as a straight leg can shortcut it: the leg may not touch land (every cell the
+// segment passes through, corners included) and may not cost more than the cells it
+// replaces. A leg costs what a Bresenham raster along it costs walked as a grid path:
+// its octile length in the searches' own step costs plus the costField penalty of the
+// cells the raster enters, so the result costs the same as the route or less. (Pricing
+// legs by Euclidean length would make every 45-degree run look dearer than the
+// staircase it replaces, since STEP_DIAGONAL is a little under sqrt(2).)
+//
+// Both tests run a row at a time over bit-packed masks, a bit per cell: land, and
+// anything that is not plain water. A row's stretch of the segment is one masked
+// word compare for steep legs and a word per 64 cells for flat ones; only legs that
+// cross padding or storms walk the raster cell by cell to add up their penalty.
+// The reach from each waypoint is found by doubling, then bisection. On a wrapping
+// chart legs stay under half its width, so two waypoints still tell which way round
+// the leg between them goes.
+
+static uint64_t* landBits = NULL;
+static uint64_t* costBits = NULL;
+static int rowWords = 0, bitsW = 0, bitsH = 0;
+
+static void buildSightMasks() {
+    rowWords = (gridW + 63) / 64;
+    size_t words = (size_t)rowWords * gridH;
+    landBits = (uint64_t*)realloc(landBits, sizeof(uint64_t) * words);
+    costBits = (uint64_t*)realloc(costBits, sizeof(uint64_t) * words);
+    memset(landBits, 0, sizeof(uint64_t) * words);
+    memset(costBits, 0, sizeof(uint64_t) * words);
+    for (int r = 0; r < gridH; r++) {
+        uint64_t* land = landBits + (size_t)r * rowWords;
+        uint64_t* cost = costBits + (size_t)r * rowWords;
+        for (int c = 0; c < gridW; c++) {
+            int idx = r * gridW + c;
+            uint64_t bit = 1ull << (c & 63);
+            if (collisionGrid[idx] == 1) land[c >> 6] |= bit;
+            if (costField[idx] != 0) cost[c >> 6] |= bit;
+        }
+    }
+    bitsW = gridW; bitsH = gridH;
+}
+
+void refreshSightMasks() {
+    if (landBits && collisionGrid && costField) buildSightMasks();
+}
+
+void freeSightMasks() {
+    free(landBits); landBits = NULL;
+    free(costBits); costBits = NULL;
+    rowWords = bitsW = bitsH = 0;
+}
+
+// Any bit set in columns c0..c1 (0 <= c0 <= c1 < gridW) of row r.
+static inline int rangeHits(const uint64_t* bits, int r, int c0, int c1) {
+    const uint64_t* row = bits + (size_t)r * rowWords;
+    int w0 = c0 >> 6, w1 = c1 >> 6;
+    uint64_t first = ~0ull << (c0 & 63), last = ~0ull >> (63 - (c1 & 63));
+    if (w0 == w1) return (row[w0] & first & last) != 0;
+    if (row[w0] & first) return 1;
+    for (int w = w0 + 1; w < w1; w++) if (row[w]) return 1;
+    return (row[w1] & last) != 0;
+}
+
+// Same for unwrapped columns lo..hi, which may run past either edge of a wrapping chart.
+static inline int spanHits(const uint64_t* bits, int r, int lo, int hi) {
+    if (hi - lo + 1 >= gridW) return rangeHits(bits, r, 0, gridW - 1);
+    lo = (lo % gridW + gridW) % gridW;
+    hi = (hi % gridW + gridW) % gridW;
+    return lo <= hi ? rangeHits(bits, r, lo, hi) : rangeHits(bits, r, lo, gridW - 1) || rangeHits(bits, r, 0, hi);
+}
+
+// Whether the segment between cell centres (r0, x0) and (r1, x1) passes through a cell
+// whose bit is set. x is an unwrapped column.
+static int segmentHits(const uint64_t* bits, int r0, int x0, int r1, int x1) {
+    if (r0 > r1) { int t = r0; r0 = r1; r1 = t; t = x0; x0 = x1; x1 = t; }
+    if (r0 == r1) return spanHits(bits, r0, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0);
+    float slope = (float)(x1 - x0) / (r1 - r0);
+    for (int r = r0; r <= r1; r++) {
+        // The segment's stretch within the row, widened a hair so corners count.
+        float ya = r == r0 ? 0.0f : r - r0 - 0.5f, yb = r == r1 ? (float)(r1 - r0) : r - r0 + 0.5f;
+        float xa = x0 + ya * slope, xb = x0 + yb * slope;
+        if (xa > xb) { float t = xa; xa = xb; xb = t; }
+        if (spanHits(bits, r, (int)floorf(xa + 0.5f - 1e-4f), (int)floorf(xb + 0.5f + 1e-4f))) return 1;
+    }
+    return 0;
+}
+
+// Penalty of the cells a Bresenham raster from (r0, x0) to (r1, x1) enters.
+static float rasterPenalty(int r0, int x0, int r1, int x1) {
+    int dr = abs(r1 - r0), dx = abs(x1 - x0), sr = r0 < r1 ? 1 : -1, sx = x0 < x1 ? 1 : -1;
+    int err = (dx > dr ? dx : -dr) / 2, r = r0, x = x0;
+    unsigned units = 0;
+    while (r != r1 || x != x1) {
+        int e = err;
+        if (e > -dx) { err -= dr; x += sx; }
+        if (e < dr) { err += dx; r += sr; }
+        int c = (x % gridW + gridW) % gridW;
+        units += costField[r * gridW + c];
+    }
+    return units * (1.0f / COST_SCALE);
+}
+
+// Cost of the straight leg between two path cells, INFINITY if it touches land.
+static float legCost(int r0, int x0, int r1, int x1) {
+    int dr = abs(r1 - r0), dx = abs(x1 - x0);
+    float length = dr > dx ? (dr - dx) * STEP_STRAIGHT + STEP_DIAGONAL * dx : (dx - dr) * STEP_STRAIGHT + STEP_DIAGONAL * dr;
+    if (!segmentHits(costBits, r0, x0, r1, x1)) return length;
+    if (segmentHits(landBits, r0, x0, r1, x1)) return INFINITY;
+    return length + rasterPenalty(r0, x0, r1, x1);
+}
+
+int smoothPath(const RoutePath* path, RoutePath* out) {
+    out->cells = NULL; out->len = 0; out->cost = 0; out->hours = 0;
+    out->expanded = path->expanded;
+    if (!collisionGrid || !costField || path->len <= 0) return 0;
+    if (!landBits || bitsW != gridW || bitsH != gridH) buildSightMasks();
+
+    int n = path->len;
+    // Unwrapped columns, and the cost of the route up to each cell.
+    int* x = (int*)malloc(sizeof(int) * n);
+    float* prefix = (float*)malloc(sizeof(float) * n);
+    x[0] = path->cells[0].c;
+    prefix[0] = 0;
+    for (int i = 1; i < n; i++) {
+        int dc = path->cells[i].c - path->cells[i - 1].c;
+        if (wrapColumns && 2 * abs(dc) > gridW) dc += dc > 0 ? -gridW : gridW;
+        x[i] = x[i - 1] + dc;
+        GridPos p = path->cells[i];
+        prefix[i] = prefix[i - 1] + enterCost(p.r * gridW + p.c, p.r != path->cells[i - 1].r && dc != 0);
+    }
+
+    out->cells = (GridPos*)malloc(sizeof(GridPos) * n);
+    out->cells[out->len++] = path->cells[0];
+    float length = 0;
+    for (int i = 0; i < n - 1; ) {
+        // The prefix is summed a step at a time and the leg in one go, so allow their
+        // rounding apart.
+        #define FITS(j) ((!wrapColumns || 2 * abs(x[j] - x[i]) < gridW) && legCost(path->cells[i].r, x[i], path->cells[j].r, x[j]) <= (prefix[j] - prefix[i]) * (1 + 1e-4f) + 1e-4f)
+        // Adjacent cells are the route's own step; beyond that, double then bisect.
+        int good = i + 1, step = 2;
+        while (good + 1 < n) {
+            int j = i + step < n ? i + step : n - 1;
+            if (!FITS(j)) break;
+            good = j;
+            step *= 2;
+        }
+        int bad = i + step < n ? i + step : n;
+        while (bad - good > 1) {
+            int mid = (good + bad) / 2;
+            if (FITS(mid)) good = mid; else bad = mid;
+        }
+        #undef FITS
+        const GridPos a = path->cells[i], b = path->cells[good];
+        float leg = sqrtf((float)((b.r - a.r) * (b.r - a.r) + (x[good] - x[i]) * (x[good] - x[i])));
+        out->cost += good == i + 1 ? prefix[good] - prefix[i] : legCost(a.r, x[i], b.r, x[good]);
+        length += leg;
+        out->cells[out->len++] = b;
+        i = good;
+    }
+    free(x); free(prefix);
+    float speed = serviceSpeed();
+    out->hours = speed > 0 ? length * nmPerCell() / speed : 0;
+    return out->len;
+}
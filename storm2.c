@@ -6,13 +6,18 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include "route.h"
+#include "textcache.h"
+#include "overlay.h"
+#include "routedraw.h"
+#include "maptiles.h"
+#include "asyncroute.h"
+#include "perf.h"
+#include "perfoverlay.h"
 
 #define WIDTH 1920
 #define HEIGHT 1080
 #define TOPBAR 0
-#define GRID_SCALE 4 
-#define PADDING_COST 50.0f
-#define STORM_THRESHOLD 30.0f 
 #define VELOCITY_SAMPLES 5 
 
 // --- Map Boundary Constants (User Provided) ---
@@ -22,42 +27,6 @@
 #define MAP_EAST 179.33f
 
 typedef struct { float x, y; int valid; float alpha; } Point;
-typedef struct { int r, c; } GridPos;
-typedef struct Node {
-    GridPos pos;
-    float g, h, f;
-    struct Node* parent;
-} Node;
-
-typedef struct { Node** nodes; int size; } MinHeap;
-
-// --- A* Heap Functions ---
-void pushHeap(MinHeap* heap, Node* node) {
-    int i = heap->size++;
-    while (i > 0) {
-        int p = (i - 1) / 2;
-        if (heap->nodes[p]->f <= node->f) break;
-        heap->nodes[i] = heap->nodes[p];
-        i = p;
-    }
-    heap->nodes[i] = node;
-}
-
-Node* popHeap(MinHeap* heap) {
-    if (heap->size == 0) return NULL;
-    Node* res = heap->nodes[0];
-    Node* last = heap->nodes[--heap->size];
-    int i = 0;
-    while (i * 2 + 1 < heap->size) {
-        int child = i * 2 + 1;
-        if (child + 1 < heap->size && heap->nodes[child + 1]->f < heap->nodes[child]->f) child++;
-        if (last->f <= heap->nodes[child]->f) break;
-        heap->nodes[i] = heap->nodes[child];
-        i = child;
-    }
-    heap->nodes[i] = last;
-    return res;
-}
 
 // --- Globals ---
 float zoom = 1.0f, targetZoom = 1.0f;
@@ -69,9 +38,8 @@ float frameVelY[VELOCITY_SAMPLES] = {0};
 int velIdx = 0;
 
 Point p1 = {0,0,0,0}, p2 = {0,0,0,0};
-SDL_Texture *mapTex = NULL, *startTex = NULL, *endTex = NULL;
+SDL_Texture *startTex = NULL, *endTex = NULL;
 Mix_Chunk* tickSound = NULL;
-int mapWidth, mapHeight;
 char infoText[128] = "Click to set A and B";
 char shipName[64] = "Unknown", shipSpeed[32] = "0 kts", shipMode[32] = "N/A";
 
@@ -96,11 +64,18 @@ void loadShipInfo() {
     }
 }
 
-unsigned char* collisionGrid = NULL;
-float* weatherGrid = NULL; 
-int gridW, gridH;
 GridPos* finalPath = NULL;
 int pathLen = 0;
+RouteDraw* routeGeom = NULL;
+// Plans on its own thread and keeps its search between clicks (see asyncroute.h).
+AsyncRoute* router = NULL;
+// What the running search has reached, drawn until its route arrives (F toggles).
+RouteProgress progress = { NULL, 0, { NULL, 0, 0, 0, 0 }, 0, 0 };
+RouteDraw* partialGeom = NULL;
+int showSearch = 1;
+// Counters and frame timings beside the ship panel (P toggles); -P trace.csv also logs
+// them every frame.
+int showPerf = 0;
 
 // --- Coordinate Helpers (Mapped to User Bounding Box) ---
 int worldToScreenX(float wx) { return (int)((wx - camX) * zoom + WIDTH / 2); }
@@ -110,159 +85,60 @@ float screenToWorldY(int sy) { return (sy - TOPBAR - HEIGHT / 2) / zoom + camY;
 float worldToPixelX(float wx) { return wx + mapWidth/2.0f; }
 float worldToPixelY(float wy) { return wy + mapHeight/2.0f; }
 
-float pixelToLat(float pixel_y) {
-    float wy = pixel_y - mapHeight/2.0f;
-    // Mercator: lat = 2 * atan(exp((y - c) / m)) - pi/2
-    // Precise derivation: m = 26.61, c = 3.11
-    return (2.0f * atanf(expf((wy - 3.11f) / 26.61f)) - (float)M_PI / 2.0f) * 180.0f / (float)M_PI;
-}
-
-float pixelToLon(float pixel_x) {
-    float wx = pixel_x - mapWidth/2.0f;
-    // Linear: Lon = (x - c) / m
-    // Precise derivation: m = 0.5581, c = 78.85
-    return (wx - 78.85f) / 0.5581f;
-}
-
-void wrapCamera() {
-    float half = mapWidth * 0.5f;
-    if (camX > half) camX -= mapWidth;
-    else if (camX < -half) camX += mapWidth;
-}
-
-// --- Weather Implementation ---
-void updateWeatherSimulation() {
-    if (!weatherGrid) return;
-    for (int r = 0; r < gridH; r++) {
-        for (int c = 0; c < gridW; c++) {
-            float lat = pixelToLat(r * GRID_SCALE);
-            float lon = pixelToLon(c * GRID_SCALE);
-            
-            // Simulating a storm near the center of the Mediterranean/Atlantic
-            // Center: 35.0 Lat, 15.0 Lon. Radius: 10 degrees
-            float dist = sqrtf(pow(lat - 35.0f, 2) + pow(lon - 15.0f, 2));
-            if (dist < 10.0f) weatherGrid[r * gridW + c] = 55.0f; // High wind speed
-            else weatherGrid[r * gridW + c] = 5.0f; 
+// Hands cells to rd in world space, x unwrapped where the route crosses the seam.
+void setRouteGeometry(RouteDraw* rd, const GridPos* cells, int len) {
+    if (!rd) return;
+    SDL_FPoint* pts = len > 1 ? (SDL_FPoint*)malloc(sizeof(SDL_FPoint) * len) : NULL;
+    for (int i = 0; pts && i < len; i++) {
+        float wx = cells[i].c * GRID_SCALE - mapWidth/2.0f;
+        if (i > 0) {
+            while (wx - pts[i-1].x > mapWidth / 2) wx -= mapWidth;
+            while (pts[i-1].x - wx > mapWidth / 2) wx += mapWidth;
         }
+        pts[i] = (SDL_FPoint){ wx, cells[i].r * GRID_SCALE - mapHeight/2.0f };
     }
+    routeDrawSet(rd, pts, pts ? len : 0);
+    free(pts);
 }
 
-// --- Logic ---
-void createCollisionGrid(SDL_Surface* surf) {
-    gridW = surf->w / GRID_SCALE;
-    gridH = surf->h / GRID_SCALE;
-    collisionGrid = (unsigned char*)malloc(gridW * gridH);
-    weatherGrid = (float*)calloc(gridW * gridH, sizeof(float));
-
-    Uint32* pixels = (Uint32*)surf->pixels;
-    for (int y = 0; y < gridH; y++) {
-        for (int x = 0; x < gridW; x++) {
-            Uint32 pixel = pixels[(y * GRID_SCALE * surf->w) + (x * GRID_SCALE)];
-            Uint8 r, g, b;
-            SDL_GetRGB(pixel, surf->format, &r, &g, &b);
-            collisionGrid[y * gridW + x] = (r == 38 && g == 38 && b == 38) ? 0 : 1; 
-        }
-    }
-    for (int y = 1; y < gridH - 1; y++) {
-        for (int x = 1; x < gridW - 1; x++) {
-            if (collisionGrid[y * gridW + x] == 0) {
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        if (collisionGrid[(y + dy) * gridW + (x + dx)] == 1) {
-                            collisionGrid[y * gridW + x] = 2;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
+// Snaps A/B onto water and hands them to the router; the route shows up in a later
+// frame through publishRoute(). A search still running for older points is dropped.
+void computeRoute() {
+    if (!p1.valid || !p2.valid || !router) return;
+    if (finalPath) { free(finalPath); finalPath = NULL; pathLen = 0; }
+    setRouteGeometry(routeGeom, NULL, 0);
+    if (!snapToWater(&p1.x, &p1.y) || !snapToWater(&p2.x, &p2.y)) {
+        asyncRouteCancel(router);
+        snprintf(infoText, sizeof(infoText), "No Route Possible");
+        return;
     }
-    updateWeatherSimulation();
+    asyncRouteStart(router, worldToGrid(p1.x, p1.y), worldToGrid(p2.x, p2.y));
+    snprintf(infoText, sizeof(infoText), "Computing Route... (Esc cancels)");
 }
 
-void snapToWater(Point* p) {
-    int c = (int)(p->x + mapWidth/2) / GRID_SCALE;
-    int r = (int)(p->y + mapHeight/2) / GRID_SCALE;
-    if (r >= 0 && r < gridH && c >= 0 && c < gridW && collisionGrid[r * gridW + c] != 1) return;
-    for (int radius = 1; radius < 25; radius++) {
-        for (int dr = -radius; dr <= radius; dr++) {
-            for (int dc = -radius; dc <= radius; dc++) {
-                int nr = r + dr, nc = c + dc;
-                if (nr >= 0 && nr < gridH && nc >= 0 && nc < gridW && collisionGrid[nr * gridW + nc] != 1) {
-                    p->x = (nc * GRID_SCALE) - mapWidth/2.0f + (GRID_SCALE/2.0f);
-                    p->y = (nr * GRID_SCALE) - mapHeight/2.0f + (GRID_SCALE/2.0f);
-                    return;
-                }
-            }
-        }
-    }
+// Takes over a finished route (already pulled taut: drawn every frame, it keeps the
+// waypoints rather than a point per cell).
+void publishRoute(RoutePath* path, int found) {
+    if (found) { finalPath = path->cells; pathLen = path->len; }
+    else freePath(path);
+    setRouteGeometry(routeGeom, finalPath, pathLen);
+    setRouteGeometry(partialGeom, NULL, 0);
+    perfTraceRow(found ? "route" : "no_route");
+    if (found && path->hours > 0)
+        snprintf(infoText, sizeof(infoText), "Route Calculated (Storms Avoided) - %dd %dh at %s",
+                 (int)(path->hours / 24), (int)path->hours % 24, shipSpeed);
+    else snprintf(infoText, sizeof(infoText), found ? "Route Calculated (Storms Avoided)" : "No Route Possible");
 }
 
-void astar() {
-    if (!p1.valid || !p2.valid) return;
-    snapToWater(&p1); snapToWater(&p2);
-    int startC = (int)(p1.x + mapWidth/2) / GRID_SCALE;
-    int startR = (int)(p1.y + mapHeight/2) / GRID_SCALE;
-    int endC = (int)(p2.x + mapWidth/2) / GRID_SCALE;
-    int endR = (int)(p2.y + mapHeight/2) / GRID_SCALE;
-
-    MinHeap openList = { malloc(sizeof(Node*) * gridW * gridH), 0 };
-    Node* nodes = (Node*)calloc(gridW * gridH, sizeof(Node));
-    float* gScore = (float*)malloc(gridW * gridH * sizeof(float));
-    for(int i=0; i<gridW*gridH; i++) gScore[i] = 1e9f;
-
-    int startIdx = startR * gridW + startC;
-    gScore[startIdx] = 0;
-    nodes[startIdx].pos = (GridPos){startR, startC};
-    nodes[startIdx].f = sqrtf(pow(startR-endR, 2) + pow(startC-endC, 2));
-    pushHeap(&openList, &nodes[startIdx]);
-
-    int found = 0;
-    while (openList.size > 0) {
-        Node* curr = popHeap(&openList);
-        if (curr->pos.r == endR && curr->pos.c == endC) {
-            found = 1; pathLen = 0; Node* temp = curr;
-            while(temp) { pathLen++; temp = temp->parent; }
-            if(finalPath) free(finalPath);
-            finalPath = malloc(sizeof(GridPos) * pathLen);
-            temp = curr;
-            for(int i=pathLen-1; i>=0; i--) { finalPath[i] = temp->pos; temp = temp->parent; }
-            break;
-        }
-
-        for (int dr = -1; dr <= 1; dr++) {
-            for (int dc = -1; dc <= 1; dc++) {
-                if (dr == 0 && dc == 0) continue;
-                int nr = curr->pos.r + dr, nc = curr->pos.c + dc;
-                if (nr < 0 || nr >= gridH || nc < 0 || nc >= gridW || collisionGrid[nr * gridW + nc] == 1) continue;
-
-                float stepCost = (dr == 0 || dc == 0) ? 1.0f : 1.414f;
-                if (collisionGrid[nr * gridW + nc] == 2) stepCost += PADDING_COST; 
-
-                // --- WEATHER PENALTY ---
-                float wind = weatherGrid[nr * gridW + nc];
-                if (wind > STORM_THRESHOLD) {
-                    stepCost += (wind * 8.0f); // Penalize storms to force routing around them
-                }
-
-                float tentativeG = gScore[curr->pos.r * gridW + curr->pos.c] + stepCost;
-                if (tentativeG < gScore[nr * gridW + nc]) {
-                    int idx = nr * gridW + nc;
-                    gScore[idx] = tentativeG;
-                    nodes[idx].pos = (GridPos){nr, nc}; nodes[idx].parent = curr;
-                    nodes[idx].g = tentativeG;
-                    nodes[idx].h = sqrtf(pow(nr - endR, 2) + pow(nc - endC, 2)) * 1.2f;
-                    nodes[idx].f = nodes[idx].g + nodes[idx].h;
-                    pushHeap(&openList, &nodes[idx]);
-                }
-            }
-        }
-    }
-    free(openList.nodes); free(nodes); free(gScore);
-    snprintf(infoText, sizeof(infoText), found ? "Route Calculated (Storms Avoided)" : "No Route Possible");
+void wrapCamera() {
+    float half = mapWidth * 0.5f;
+    if (camX > half) camX -= mapWidth;
+    else if (camX < -half) camX += mapWidth;
 }
 
 int main(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (!strcmp(argv[i], "-P") && !perfTraceOpen(argv[++i])) fprintf(stderr, "cannot open %s\n", argv[i]);
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
     TTF_Init(); IMG_Init(IMG_INIT_PNG);
     Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 512);
@@ -274,16 +150,31 @@ int main(int argc, char* argv[]) {
     startTex = IMG_LoadTexture(ren, "assets/start.png");
     endTex = IMG_LoadTexture(ren, "assets/end.png");
     loadShipInfo();
-    SDL_Surface* tempSurf = IMG_Load("assets/temp1.png");
-    SDL_Surface* surf = SDL_ConvertSurfaceFormat(tempSurf, SDL_PIXELFORMAT_ARGB8888, 0);
-    SDL_FreeSurface(tempSurf);
-    mapWidth = surf->w; mapHeight = surf->h;
-    createCollisionGrid(surf);
-    mapTex = SDL_CreateTextureFromSurface(ren, surf);
-    SDL_FreeSurface(surf);
+    setServiceSpeed((float)atof(shipSpeed));
+    // The chart spans the globe (and is drawn wrapped), so routes may cross its edges.
+    setMapWraps(1);
+    // Both the grid and the tile pyramid come precompiled; the image is only decoded
+    // when one of them is missing or stale (the pyramid on a thread of its own).
+    uint64_t mapHash = hashFile("assets/temp1.png");
+    if (!loadCompiledGrid("assets/temp1.grid", mapHash)) {
+        SDL_Surface* tempSurf = IMG_Load("assets/temp1.png");
+        SDL_Surface* surf = SDL_ConvertSurfaceFormat(tempSurf, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(tempSurf);
+        createCollisionGrid((const Uint32*)surf->pixels, surf->w, surf->h);
+        saveCompiledGrid("assets/temp1.grid", mapHash);
+        SDL_FreeSurface(surf);
+    }
+    MapTiles* chart = mapTilesOpen(ren, "assets/temp1.png", "assets/temp1.tiles", mapHash);
 
     TTF_Font* font = TTF_OpenFont("assets/fonts/DejaVuSans.ttf", 16);
     TTF_Font* smallFont = TTF_OpenFont("assets/fonts/DejaVuSans.ttf", 12);
+    TextCache* text = textCacheCreate(ren);
+    WeatherOverlay* weather = weatherOverlayCreate(ren);
+    routeGeom = routeDrawCreate(ren);
+    partialGeom = routeDrawCreate(ren);
+    router = asyncRouteCreate();
+    PerfOverlay* perfPanel = perfOverlayCreate(ren);
+    perfTraceRow("startup");
 
     int dragging = 0, lastMouseX = 0, lastMouseY = 0, running = 1;
     Uint32 lastTicks = SDL_GetTicks();
@@ -312,18 +203,18 @@ int main(int argc, char* argv[]) {
                 camY = wy - (my - HEIGHT / 2.0f) / nextZoom;
             }
             if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
-                // Logic: 1st click -> A, 2nd click -> B, 3rd click -> Clear & Set A
+                // Logic: 1st click -> A, 2nd click -> B, 3rd click -> Move A and replan to the same B
+                // (Shift+click moves B)
                 float wx = screenToWorldX(e.button.x), wy = screenToWorldY(e.button.y);
                 if (p1.valid && p2.valid) {
-                        // Reset state on 3rd click
-                        p1.valid = 0; p2.valid = 0; pathLen = 0;
-                        if (finalPath) { free(finalPath); finalPath = NULL; }
-                        p1 = (Point){wx, wy, 1, 0}; // Set new A
+                        if (SDL_GetModState() & KMOD_SHIFT) p2 = (Point){wx, wy, 1, 0};
+                        else p1 = (Point){wx, wy, 1, 0}; // Set new A
+                        computeRoute(); // Repairs the previous search
                 } else if (!p1.valid) { 
                     p1 = (Point){wx, wy, 1, 0}; 
                 } else if (!p2.valid) { 
                     p2 = (Point){wx, wy, 1, 0}; 
-                    astar(); // Auto-compute path
+                    computeRoute(); // Auto-compute path
                 }
             }
             if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_RIGHT) { 
@@ -346,6 +237,12 @@ int main(int argc, char* argv[]) {
                 velIdx = (velIdx + 1) % VELOCITY_SAMPLES;
                 lastMouseX = e.motion.x; lastMouseY = e.motion.y; wrapCamera();
             }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE && router && asyncRouteBusy(router)) {
+                asyncRouteCancel(router);
+                snprintf(infoText, sizeof(infoText), "Route Cancelled");
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_f) showSearch = !showSearch;
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_p) showPerf = !showPerf;
 
         }
 
@@ -366,40 +263,64 @@ int main(int argc, char* argv[]) {
             if (camY > limit) camY = limit;
         }
 
+        // --- Route Handoff ---
+        RoutePath done;
+        int found;
+        if (router && asyncRouteTake(router, &done, &found)) publishRoute(&done, found);
+        int searching = router && asyncRouteBusy(router);
+        if (searching && asyncRoutePollProgress(router, &progress)) {
+            setRouteGeometry(partialGeom, progress.partial.cells, progress.partial.len);
+            snprintf(infoText, sizeof(infoText), "Computing Route... %d cells searched (Esc cancels)", progress.expanded);
+        }
+
         if (p1.valid && p1.alpha < 255) p1.alpha += 15;
         if (p2.valid && p2.alpha < 255) p2.alpha += 15;
 
+        PERF_TIMER(frameStart);
         SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
         SDL_RenderClear(ren);
 
-        for (int dx = -1; dx <= 1; dx++) {
-            SDL_Rect dst = {worldToScreenX(-mapWidth/2 + dx*mapWidth), worldToScreenY(-mapHeight/2), (int)(mapWidth*zoom), (int)(mapHeight*zoom)};
-            SDL_RenderCopy(ren, mapTex, NULL, &dst);
-        }
+        // Copies off screen cost nothing: only visible tiles are drawn.
+        PERF_TIMER(chartStart);
+        for (int dx = -1; dx <= 1; dx++)
+            mapTilesDraw(chart, worldToScreenX(-mapWidth/2 + dx*mapWidth), worldToScreenY(-mapHeight/2), zoom);
+        PERF_PHASE(PERF_DRAW_CHART, chartStart);
 
         // --- Render Weather Overlay ---
+        PERF_TIMER(overlayStart);
         SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-        for (int r = 0; r < gridH; r += 2) {
-            for (int c = 0; c < gridW; c += 2) {
-                if (weatherGrid[r * gridW + c] > STORM_THRESHOLD) {
-                    SDL_SetRenderDrawColor(ren, 255, 0, 0, 50); 
-                    float wx = c * GRID_SCALE - mapWidth/2.0f;
-                    float wy = r * GRID_SCALE - mapHeight/2.0f;
-                    SDL_Rect wr = { worldToScreenX(wx), worldToScreenY(wy), (int)(GRID_SCALE * 2 * zoom), (int)(GRID_SCALE * 2 * zoom) };
-                    SDL_RenderFillRect(ren, &wr);
-                }
-            }
-        }
+        for (int dx = -1; dx <= 1; dx++)
+            weatherOverlayDraw(weather, worldToScreenX(-mapWidth/2 + dx*mapWidth), worldToScreenY(-mapHeight/2), zoom);
+        PERF_PHASE(PERF_DRAW_OVERLAY, overlayStart);
 
+        PERF_TIMER(routeStart);
         if (finalPath) {
             SDL_SetRenderDrawColor(ren, 0, 180, 255, 255);
-            for (int i = 0; i < pathLen - 1; i++) {
-                float wx1 = finalPath[i].c * GRID_SCALE - mapWidth/2.0f, wy1 = finalPath[i].r * GRID_SCALE - mapHeight/2.0f;
-                float wx2 = finalPath[i+1].c * GRID_SCALE - mapWidth/2.0f, wy2 = finalPath[i+1].r * GRID_SCALE - mapHeight/2.0f;
-                if (fabs(wx1 - wx2) < mapWidth / 2) SDL_RenderDrawLine(ren, worldToScreenX(wx1), worldToScreenY(wy1), worldToScreenX(wx2), worldToScreenY(wy2));
+            // Once per map copy: a route over the seam continues on the neighbouring copy.
+            for (int dx = -1; dx <= 1; dx++)
+                routeDrawRender(routeGeom, (dx * mapWidth - camX) * zoom + WIDTH / 2, -camY * zoom + HEIGHT / 2 + TOPBAR, zoom);
+        }
+
+        if (searching && showSearch) {
+            // The search so far: a sample of its frontier, and the best route it has to B.
+            static SDL_Rect marks[ASYNC_FRONTIER_MAX];
+            int size = GRID_SCALE * zoom > 2 ? (int)(GRID_SCALE * zoom) : 2;
+            SDL_SetRenderDrawColor(ren, 255, 140, 0, 160);
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int i = 0; i < progress.frontierLen; i++) {
+                    float wx = progress.frontier[i].c * GRID_SCALE - mapWidth/2.0f + dx * mapWidth;
+                    float wy = progress.frontier[i].r * GRID_SCALE - mapHeight/2.0f;
+                    marks[i] = (SDL_Rect){ worldToScreenX(wx), worldToScreenY(wy), size, size };
+                }
+                SDL_RenderFillRects(ren, marks, progress.frontierLen);
             }
+            SDL_SetRenderDrawColor(ren, 255, 200, 0, 255);
+            for (int dx = -1; dx <= 1; dx++)
+                routeDrawRender(partialGeom, (dx * mapWidth - camX) * zoom + WIDTH / 2, -camY * zoom + HEIGHT / 2 + TOPBAR, zoom);
         }
+        PERF_PHASE(PERF_DRAW_ROUTE, routeStart);
 
+        PERF_TIMER(textStart);
         Point* pts[2] = {&p1, &p2};
         const char* labels[2] = {"A", "B"};
         SDL_Texture* icons[2] = {startTex, endTex};
@@ -408,11 +329,7 @@ int main(int argc, char* argv[]) {
                 SDL_SetTextureAlphaMod(icons[i], (Uint8)pts[i]->alpha);
                 SDL_Rect r = {worldToScreenX(pts[i]->x)-12, worldToScreenY(pts[i]->y)-12, 25, 25};
                 SDL_RenderCopy(ren, icons[i], NULL, &r);
-                SDL_Surface* s = TTF_RenderText_Blended(smallFont, labels[i], (SDL_Color){255,0,0,255});
-                SDL_Texture* t = SDL_CreateTextureFromSurface(ren, s);
-                SDL_Rect tr = {worldToScreenX(pts[i]->x)+8, worldToScreenY(pts[i]->y)-20, s->w, s->h};
-                SDL_RenderCopy(ren, t, NULL, &tr);
-                SDL_FreeSurface(s); SDL_DestroyTexture(t);
+                textDraw(text, smallFont, labels[i], (SDL_Color){255,0,0,255}, worldToScreenX(pts[i]->x)+8, worldToScreenY(pts[i]->y)-20);
             }
         }
 
@@ -424,11 +341,7 @@ int main(int argc, char* argv[]) {
             snprintf(coords, sizeof(coords), "A: (%.4f, %.4f) B: (%.4f, %.4f) | %s", 
                      pixelToLat(worldToPixelY(p1.y)), pixelToLon(worldToPixelX(p1.x)),
                      pixelToLat(worldToPixelY(p2.y)), pixelToLon(worldToPixelX(p2.x)), infoText);
-            SDL_Surface* cs = TTF_RenderText_Blended(font, coords, (SDL_Color){255,255,0,255});
-            SDL_Texture* ct = SDL_CreateTextureFromSurface(ren, cs);
-            SDL_Rect cr = {10, 12, cs->w, cs->h};
-            SDL_RenderCopy(ren, ct, NULL, &cr);
-            SDL_FreeSurface(cs); SDL_DestroyTexture(ct);
+            textDrawGlyphs(text, font, coords, (SDL_Color){255,255,0,255}, 10, 12);
         }
 
         // --- Ship Info Panel ---
@@ -442,20 +355,29 @@ int main(int argc, char* argv[]) {
         snprintf(display1, sizeof(display1), "%s", shipName);
         snprintf(display2, sizeof(display2), "Speed: %s | Mode: %s", shipSpeed, shipMode);
         
-        SDL_Surface* s1 = TTF_RenderText_Blended(font, display1, (SDL_Color){255,255,255,255});
-        SDL_Texture* t1 = SDL_CreateTextureFromSurface(ren, s1);
-        SDL_Rect r1 = {sidePanel.x + 10, sidePanel.y + 10, s1->w, s1->h};
-        SDL_RenderCopy(ren, t1, NULL, &r1);
-        SDL_FreeSurface(s1); SDL_DestroyTexture(t1);
-
-        SDL_Surface* s2 = TTF_RenderText_Blended(smallFont, display2, (SDL_Color){200,200,200,255});
-        SDL_Texture* t2 = SDL_CreateTextureFromSurface(ren, s2);
-        SDL_Rect r2 = {sidePanel.x + 10, sidePanel.y + 40, s2->w, s2->h};
-        SDL_RenderCopy(ren, t2, NULL, &r2);
-        SDL_FreeSurface(s2); SDL_DestroyTexture(t2);
+        textDraw(text, font, display1, (SDL_Color){255,255,255,255}, sidePanel.x + 10, sidePanel.y + 10);
+        textDraw(text, smallFont, display2, (SDL_Color){200,200,200,255}, sidePanel.x + 10, sidePanel.y + 40);
+        if (showPerf) perfOverlayDraw(perfPanel, text, smallFont, sidePanel.x, sidePanel.y + sidePanel.h + 10, sidePanel.w);
+        PERF_PHASE(PERF_DRAW_TEXT, textStart);
+        PERF_PHASE(PERF_FRAME, frameStart);
 
+        PERF_TIMER(presentStart);
         SDL_RenderPresent(ren);
+        PERF_PHASE(PERF_PRESENT, presentStart);
+        textCacheEndFrame(text);
+        mapTilesEndFrame(chart);
+        perfEndFrame();
+        perfTraceRow("frame");
     }
+    perfTraceClose();
+    perfOverlayFree(perfPanel);
+    routeDrawFree(routeGeom);
+    mapTilesFree(chart);
+    weatherOverlayFree(weather);
+    textCacheFree(text);
     TTF_CloseFont(font); TTF_CloseFont(smallFont);
+    asyncRouteFree(router);
+    routeProgressFree(&progress);
+    routeDrawFree(partialGeom);
     SDL_Quit(); return 0;
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "textcache.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Entries are found by a linear scan comparing hashes first; a viewer draws a
+// handful of strings a frame, so a small table beats anything cleverer. On a miss the
+// empty or least recently drawn slot is reused.
+
+#define TEXT_CACHE_SLOTS 64
+#define TEXT_IDLE_FRAMES 120    // about two seconds at 60 fps
+#define ATLAS_FIRST 32          // printable ASCII
+#define ATLAS_GLYPHS 95
+#define ATLAS_FONTS 4
+
+typedef struct {
+    TTF_Font* font;
+    SDL_Color color;
+    uint32_t hash;
+    char* text;             // NULL when the slot is free
+    SDL_Texture* tex;
+    int w, h;
+    unsigned lastUsed;
+} TextEntry;
+
+typedef struct {
+    TTF_Font* font;
+    SDL_Texture* tex;       // white glyphs, tinted per draw
+    SDL_Rect glyph[ATLAS_GLYPHS];
+    int advance[ATLAS_GLYPHS];
+} GlyphAtlas;
+
+struct TextCache {
+    SDL_Renderer* ren;
+    TextEntry entries[TEXT_CACHE_SLOTS];
+    GlyphAtlas atlases[ATLAS_FONTS];
+    int atlasCount;
+    unsigned frame;
+    int renders;
+};
+
+TextCache* textCacheCreate(SDL_Renderer* ren) {
+    TextCache* tc = (TextCache*)calloc(1, sizeof(TextCache));
+    if (tc) tc->ren = ren;
+    return tc;
+}
+
+static void dropEntry(TextEntry* e) {
+    if (e->tex) SDL_DestroyTexture(e->tex);
+    free(e->text);
+    memset(e, 0, sizeof(*e));
+}
+
+void textCacheFree(TextCache* tc) {
+    if (!tc) return;
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) dropEntry(&tc->entries[i]);
+    for (int i = 0; i < tc->atlasCount; i++) if (tc->atlases[i].tex) SDL_DestroyTexture(tc->atlases[i].tex);
+    free(tc);
+}
+
+static uint32_t textHash(const char* text) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) h = (h ^ *p) * 16777619u;
+    return h;
+}
+
+static int sameColor(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static TextEntry* findEntry(TextCache* tc, TTF_Font* font, const char* text, SDL_Color color) {
+    uint32_t h = textHash(text);
+    TextEntry* victim = &tc->entries[0];
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        TextEntry* e = &tc->entries[i];
+        if (e->text && e->hash == h && e->font == font && sameColor(e->color, color) && !strcmp(e->text, text)) return e;
+        if (!victim->text) continue;
+        if (!e->text || e->lastUsed < victim->lastUsed) victim = e;
+    }
+    dropEntry(victim);
+    SDL_Surface* s = TTF_RenderText_Blended(font, text, color);
+    if (!s) return NULL;
+    victim->tex = SDL_CreateTextureFromSurface(tc->ren, s);
+    victim->w = s->w; victim->h = s->h;
+    SDL_FreeSurface(s);
+    if (!victim->tex) return NULL;
+    victim->text = strdup(text);
+    victim->font = font; victim->color = color; victim->hash = h;
+    tc->renders++;
+    return victim;
+}
+
+SDL_Rect textDraw(TextCache* tc, TTF_Font* font, const char* text, SDL_Color color, int x, int y) {
+    SDL_Rect r = { x, y, 0, 0 };
+    if (!font || !text || !*text) return r;
+    TextEntry* e = findEntry(tc, font, text, color);
+    if (!e) return r;
+    e->lastUsed = tc->frame;
+    r.w = e->w; r.h = e->h;
+    SDL_RenderCopy(tc->ren, e->tex, NULL, &r);
+    return r;
+}
+
+// --- Glyph Atlas ---
+static GlyphAtlas* atlasFor(TextCache* tc, TTF_Font* font) {
+    for (int i = 0; i < tc->atlasCount; i++) if (tc->atlases[i].font == font) return &tc->atlases[i];
+    if (tc->atlasCount == ATLAS_FONTS) return NULL;
+    GlyphAtlas* a = &tc->atlases[tc->atlasCount];
+    memset(a, 0, sizeof(*a));
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface* glyphs[ATLAS_GLYPHS];
+    int width = 0, height = 0;
+    for (int g = 0; g < ATLAS_GLYPHS; g++) {
+        Uint16 ch = (Uint16)(ATLAS_FIRST + g);
+        glyphs[g] = TTF_RenderGlyph_Blended(font, ch, white);
+        int minx, maxx, miny, maxy, advance = 0;
+        if (TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance) != 0 && glyphs[g]) advance = glyphs[g]->w;
+        a->advance[g] = advance;
+        if (!glyphs[g]) continue;
+        a->glyph[g] = (SDL_Rect){ width, 0, glyphs[g]->w, glyphs[g]->h };
+        width += glyphs[g]->w + 1;
+        if (glyphs[g]->h > height) height = glyphs[g]->h;
+    }
+    // One strip, glyphs copied over as they are (alpha included) and kept white.
+    SDL_Surface* strip = width > 0 ? SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888) : NULL;
+    for (int g = 0; g < ATLAS_GLYPHS; g++) {
+        if (!glyphs[g]) continue;
+        if (strip) {
+            SDL_SetSurfaceBlendMode(glyphs[g], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphs[g], NULL, strip, &a->glyph[g]);
+        }
+        SDL_FreeSurface(glyphs[g]);
+    }
+    if (!strip) return NULL;
+    a->tex = SDL_CreateTextureFromSurface(tc->ren, strip);
+    SDL_FreeSurface(strip);
+    if (!a->tex) return NULL;
+    SDL_SetTextureBlendMode(a->tex, SDL_BLENDMODE_BLEND);
+    a->font = font;
+    tc->atlasCount++;
+    tc->renders += ATLAS_GLYPHS;
+    return a;
+}
+
+SDL_Rect textDrawGlyphs(TextCache* tc, TTF_Font* font, const char* text, SDL_Color color, int x, int y) {
+    SDL_Rect r = { x, y, 0, 0 };
+    if (!font || !text || !*text) return r;
+    GlyphAtlas* a = atlasFor(tc, font);
+    if (!a) return textDraw(tc, font, text, color, x, y);
+    SDL_SetTextureColorMod(a->tex, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(a->tex, color.a);
+    int pen = x;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        int g = *p - ATLAS_FIRST;
+        if (g < 0 || g >= ATLAS_GLYPHS) g = '?' - ATLAS_FIRST;
+        const SDL_Rect* src = &a->glyph[g];
+        if (src->w > 0) {
+            SDL_Rect dst = { pen, y, src->w, src->h };
+            SDL_RenderCopy(tc->ren, a->tex, src, &dst);
+            if (src->h > r.h) r.h = src->h;
+        }
+        pen += a->advance[g];
+    }
+    r.w = pen - x;
+    return r;
+}
+
+void textCacheEndFrame(TextCache* tc) {
+    tc->frame++;
+    for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        TextEntry* e = &tc->entries[i];
+        if (e->text && tc->frame - e->lastUsed > TEXT_IDLE_FRAMES) dropEntry(e);
+    }
+}
+
+int textCacheRenders(const TextCache* tc) { return tc->renders; }
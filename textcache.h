@@ -0,0 +1,26 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+// Text drawing for the viewers (storm.c, storm2.c). A string is rasterized once and its
+// texture reused for as long as it is drawn with the same font and colour; one that
+// has not been drawn for a couple of seconds (it changed, or its panel closed) is
+// dropped. Text whose digits change from frame to frame is better drawn glyph by glyph
+// from a per-font atlas, which never rasterizes after the first use of the font.
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+typedef struct TextCache TextCache;
+
+TextCache* textCacheCreate(SDL_Renderer* ren);
+void textCacheFree(TextCache* tc);
+// Draws text with its top-left corner at x, y and returns the rectangle it covered
+// (empty without a font or text).
+SDL_Rect textDraw(TextCache* tc, TTF_Font* font, const char* text, SDL_Color color, int x, int y);
+// Same from the glyph atlas: printable ASCII only, no kerning.
+SDL_Rect textDrawGlyphs(TextCache* tc, TTF_Font* font, const char* text, SDL_Color color, int x, int y);
+// Call once per frame, after drawing: ages the cache and drops idle strings.
+void textCacheEndFrame(TextCache* tc);
+// Strings rasterized so far (cache misses plus atlas glyphs).
+int textCacheRenders(const TextCache* tc);
+
+#endif
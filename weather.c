@@ -0,0 +1,164 @@
+#include "searchctx.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// --- Weather Implementation ---
+// Ambient wind plus any number of storms. Latitude only depends on the row and
+// longitude on the column, so both are looked up from tables built once per grid
+// instead of an atanf(expf()) per cell. Rows are split across threads; within a row
+// each storm touches only the columns inside its radius, four at a time with SSE
+// (the scalar tail does the same arithmetic in the same order).
+
+#define MAX_STORMS 256
+
+// The original hard-coded storm: 55 kts within 10 degrees of 35N 15E, stationary.
+static Storm storms[MAX_STORMS] = { { 35.0f, 15.0f, 10.0f, 10.0f, 55.0f, 0.0f, 0.0f } };
+static int stormCount = 1;
+static float ambientWind = 5.0f;
+
+static float* rowLat = NULL;
+static float* colLon = NULL;
+static int tableW = 0, tableH = 0, tableMapW = 0, tableMapH = 0;
+
+typedef struct {
+    float lat, lon;
+    float outer2;       // radius squared
+    float invBand;      // 1 / (radius^2 - core^2); huge for a flat profile
+    float rise;         // peak - ambient
+} StormShape;
+
+typedef struct {
+    StormShape shapes[MAX_STORMS];
+    int count;
+    float ambient;
+    float* out;         // gridW*gridH winds
+} WeatherJob;
+
+void setStorms(const Storm* list, int count, float ambient) {
+    if (count > MAX_STORMS) count = MAX_STORMS;
+    if (count > 0) memcpy(storms, list, sizeof(Storm) * count);
+    stormCount = count > 0 ? count : 0;
+    ambientWind = ambient;
+}
+
+int currentStorms(Storm* list, int max, float* ambient) {
+    int n = stormCount < max ? stormCount : max;
+    if (n > 0) memcpy(list, storms, sizeof(Storm) * n);
+    if (ambient) *ambient = ambientWind;
+    return stormCount;
+}
+
+int loadStorms(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    Storm list[MAX_STORMS];
+    int count = 0;
+    float ambient = ambientWind;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* hash = strchr(line, '#'); if (hash) *hash = '\0';
+        for (char* p = line; *p; p++) if (*p == ',' || *p == ';') *p = ' ';
+        float v[7];
+        if (sscanf(line, " ambient %f", &v[0]) == 1) { ambient = v[0]; continue; }
+        int n = sscanf(line, "%f %f %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]);
+        if (n < 4 || n == 6 || count == MAX_STORMS) continue;
+        Storm s = { v[0], v[1], v[2], n >= 5 ? v[4] : v[2], v[3], n == 7 ? v[5] : 0.0f, n == 7 ? v[6] : 0.0f };
+        if (s.coreRadius > s.radius) s.coreRadius = s.radius;
+        list[count++] = s;
+    }
+    fclose(f);
+    setStorms(list, count, ambient);
+    return count;
+}
+
+static void buildCoordinateTables() {
+    if (tableW == gridW && tableH == gridH && tableMapW == mapWidth && tableMapH == mapHeight) return;
+    rowLat = (float*)realloc(rowLat, sizeof(float) * gridH);
+    colLon = (float*)realloc(colLon, sizeof(float) * gridW);
+    for (int r = 0; r < gridH; r++) rowLat[r] = pixelToLat(r * GRID_SCALE);
+    for (int c = 0; c < gridW; c++) colLon[c] = pixelToLon(c * GRID_SCALE);
+    tableW = gridW; tableH = gridH; tableMapW = mapWidth; tableMapH = mapHeight;
+}
+
+// First column whose longitude is >= lon (colLon increases with the column).
+static int firstColumnAt(float lon) {
+    int lo = 0, hi = gridW;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (colLon[mid] < lon) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static void weatherRows(void* arg, int r0, int r1) {
+    const WeatherJob* job = (const WeatherJob*)arg;
+    const float* restrict lon = colLon;
+    for (int r = r0; r < r1; r++) {
+        float* restrict row = job->out + r * gridW;
+        for (int c = 0; c < gridW; c++) row[c] = job->ambient;
+        for (int k = 0; k < job->count; k++) {
+            const StormShape* s = &job->shapes[k];
+            float dlat = rowLat[r] - s->lat;
+            float dlat2 = dlat * dlat;
+            if (dlat2 >= s->outer2) continue;
+            float halfSpan = sqrtf(s->outer2 - dlat2);
+            int c0 = firstColumnAt(s->lon - halfSpan), c1 = firstColumnAt(s->lon + halfSpan) + 1;
+            if (c1 > gridW) c1 = gridW;
+            float outer2 = s->outer2, invBand = s->invBand, rise = s->rise, center = s->lon, base = job->ambient;
+            int c = c0;
+#ifdef __SSE2__
+            __m128 vOuter = _mm_set1_ps(outer2), vInvBand = _mm_set1_ps(invBand), vRise = _mm_set1_ps(rise);
+            __m128 vCenter = _mm_set1_ps(center), vBase = _mm_set1_ps(base), vDlat2 = _mm_set1_ps(dlat2);
+            __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+            for (; c + 4 <= c1; c += 4) {
+                __m128 dlon = _mm_sub_ps(_mm_loadu_ps(lon + c), vCenter);
+                __m128 t = _mm_mul_ps(_mm_sub_ps(vOuter, _mm_add_ps(vDlat2, _mm_mul_ps(dlon, dlon))), vInvBand);
+                t = _mm_min_ps(_mm_max_ps(t, zero), one);
+                __m128 wind = _mm_add_ps(vBase, _mm_mul_ps(t, vRise));
+                _mm_storeu_ps(row + c, _mm_max_ps(wind, _mm_loadu_ps(row + c)));
+            }
+#endif
+            for (; c < c1; c++) {
+                float dlon = lon[c] - center;
+                float t = (outer2 - (dlat2 + dlon * dlon)) * invBand;
+                t = t < 0.0f ? 0.0f : t;
+                t = t > 1.0f ? 1.0f : t;
+                float wind = base + t * rise, current = row[c];
+                row[c] = wind > current ? wind : current;
+            }
+        }
+    }
+}
+
+void computeWind(float* out, float hours) {
+    buildCoordinateTables();
+    WeatherJob* job = (WeatherJob*)malloc(sizeof(WeatherJob));
+    job->count = stormCount;
+    job->ambient = ambientWind;
+    job->out = out;
+    for (int k = 0; k < stormCount; k++) {
+        const Storm* s = &storms[k];
+        StormShape* shape = &job->shapes[k];
+        shape->lat = s->lat + s->driftLat * hours;
+        shape->lon = s->lon + s->driftLon * hours;
+        shape->outer2 = s->radius * s->radius;
+        float band = shape->outer2 - s->coreRadius * s->coreRadius;
+        shape->invBand = band > 0.0f ? 1.0f / band : 1e30f;
+        shape->rise = s->peakWind - ambientWind;
+    }
+    parallelFor(gridH, weatherRows, job);
+    free(job);
+}
+
+void updateWeatherSimulation() {
+    if (!weatherGrid) return;
+    PERF_TIMER(t0);
+    computeWind(weatherGrid, 0.0f);
+    PERF_PHASE(PERF_WEATHER, t0);
+    refreshDerivedGrids();
+}